@@ -15,6 +15,7 @@
 // originating logger.
 
 #include <spdlog/async_logger.h>
+#include <spdlog/details/crash_handler.h>
 #include <spdlog/details/registry.h>
 #include <spdlog/details/thread_pool.h>
 
@@ -63,6 +64,7 @@ struct async_factory_impl
 
 using async_factory = async_factory_impl<async_overflow_policy::block>;
 using async_factory_nonblock = async_factory_impl<async_overflow_policy::overrun_oldest>;
+using async_factory_discard = async_factory_impl<async_overflow_policy::discard_new>;
 
 // 包装一下创造函数 提供不同接口
 template<typename Sink, typename... SinkArgs>
@@ -77,13 +79,41 @@ inline std::shared_ptr<spdlog::logger> create_async_nb(std::string logger_name,
     return async_factory_nonblock::create<Sink>(std::move(logger_name), std::forward<SinkArgs>(sink_args)...);
 }
 
+// never blocks, nor waits for the queue lock - new messages are dropped while the queue is full
+template<typename Sink, typename... SinkArgs>
+inline std::shared_ptr<spdlog::logger> create_async_discard(std::string logger_name, SinkArgs &&...sink_args)
+{
+    return async_factory_discard::create<Sink>(std::move(logger_name), std::forward<SinkArgs>(sink_args)...);
+}
+
 // set global thread pool.
-inline void init_thread_pool(size_t q_size, size_t thread_count, std::function<void()> on_thread_start)
+inline void init_thread_pool(size_t q_size, size_t thread_count, std::function<void()> on_thread_start, async_queue_type queue_type,
+    async_sharding sharding, async_wait_strategy wait_strategy)
 {
-    auto tp = std::make_shared<details::thread_pool>(q_size, thread_count, on_thread_start);
+    auto tp = std::make_shared<details::thread_pool>(q_size, thread_count, on_thread_start, queue_type, sharding, wait_strategy);
     details::registry::instance().set_tp(std::move(tp));
 }
 
+// set global thread pool.
+inline void init_thread_pool(
+    size_t q_size, size_t thread_count, std::function<void()> on_thread_start, async_queue_type queue_type, async_sharding sharding)
+{
+    auto tp = std::make_shared<details::thread_pool>(q_size, thread_count, on_thread_start, queue_type, sharding);
+    details::registry::instance().set_tp(std::move(tp));
+}
+
+// set global thread pool.
+inline void init_thread_pool(size_t q_size, size_t thread_count, std::function<void()> on_thread_start, async_queue_type queue_type)
+{
+    init_thread_pool(q_size, thread_count, std::move(on_thread_start), queue_type, async_sharding::none);
+}
+
+// set global thread pool.
+inline void init_thread_pool(size_t q_size, size_t thread_count, std::function<void()> on_thread_start)
+{
+    init_thread_pool(q_size, thread_count, std::move(on_thread_start), async_queue_type::blocking);
+}
+
 // set global thread pool.
 inline void init_thread_pool(size_t q_size, size_t thread_count)
 {
@@ -95,4 +125,29 @@ inline std::shared_ptr<spdlog::details::thread_pool> thread_pool()
 {
     return details::registry::instance().get_tp();
 }
+
+// opt-in crash handler: on fatal signals and std::terminate write the messages still queued in the
+// thread pools and the backtraces of the loggers to fd.
+// see details/crash_handler.h
+inline void enable_crash_handler(int fd)
+{
+    details::crash_handler::install(fd);
+}
+
+inline void disable_crash_handler()
+{
+    details::crash_handler::uninstall();
+}
+
+// report the stats of the global thread pool every interval. a zero interval stops the reporting.
+inline void report_thread_pool_stats_every(
+    std::chrono::seconds interval, std::function<void(const details::thread_pool_stats &)> callback)
+{
+    auto tp = thread_pool();
+    if (tp == nullptr)
+    {
+        throw_spdlog_ex("report_thread_pool_stats_every: the global thread pool was not created");
+    }
+    tp->report_stats_every(interval, std::move(callback));
+}
 } // namespace spdlog
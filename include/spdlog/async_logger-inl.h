@@ -10,8 +10,10 @@
 #include <spdlog/sinks/sink.h>
 #include <spdlog/details/thread_pool.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <vector>
 
 SPDLOG_INLINE spdlog::async_logger::async_logger(
     std::string logger_name, sinks_init_list sinks_list, std::weak_ptr<details::thread_pool> tp, async_overflow_policy overflow_policy)
@@ -23,12 +25,87 @@ SPDLOG_INLINE spdlog::async_logger::async_logger(
     : async_logger(std::move(logger_name), {std::move(single_sink)}, std::move(tp), overflow_policy)
 {}
 
+SPDLOG_INLINE spdlog::async_logger::async_logger(const async_logger &other)
+    : std::enable_shared_from_this<async_logger>(other)
+    , logger(other)
+    , thread_pool_(other.thread_pool_)
+    , loggers_(other.loggers_)
+    , overflow_policy_(other.overflow_policy_)
+    , name_hash_(other.name_hash_)
+{}
+
+// the queued messages reference this logger by its id in the logger table. hand them
+// over to a copy of it, which the thread pool frees once they were processed.
+SPDLOG_INLINE spdlog::async_logger::~async_logger()
+{
+    auto id = logger_id_.load(std::memory_order_acquire);
+    if (id == 0)
+    {
+        return;
+    }
+    std::shared_ptr<async_logger> copy;
+    SPDLOG_TRY
+    {
+        copy = std::make_shared<async_logger>(*this);
+    }
+    SPDLOG_CATCH_ALL() {}
+    SPDLOG_TRY
+    {
+        // without a copy the entry is freed right away (its messages are dropped)
+        loggers_->retire(id, std::move(copy));
+        if (auto pool_ptr = thread_pool_.lock())
+        {
+            pool_ptr->post_retire(this, id);
+        }
+    }
+    SPDLOG_CATCH_ALL() {}
+}
+
+SPDLOG_INLINE std::shared_ptr<spdlog::details::logger_table> spdlog::async_logger::loggers_of_(
+    const std::weak_ptr<details::thread_pool> &tp)
+{
+    auto pool_ptr = tp.lock();
+    return pool_ptr ? pool_ptr->loggers() : nullptr;
+}
+
+SPDLOG_INLINE uint64_t spdlog::async_logger::registered_id_()
+{
+    auto id = logger_id_.load(std::memory_order_acquire);
+    if (id == 0)
+    {
+        auto new_id = loggers_->add(shared_from_this());
+        if (logger_id_.compare_exchange_strong(id, new_id, std::memory_order_acq_rel))
+        {
+            id = new_id;
+        }
+        else
+        {
+            loggers_->release(new_id); // registered by another thread meanwhile
+        }
+    }
+    return id;
+}
+
 // send the log message to the thread pool
 SPDLOG_INLINE void spdlog::async_logger::sink_it_(const details::log_msg &msg)
 {
     if (auto pool_ptr = thread_pool_.lock())
     {
-        pool_ptr->post_log(shared_from_this(), msg, overflow_policy_);
+        pool_ptr->post_log(this, msg, overflow_policy_);
+    }
+    else
+    {
+        throw_spdlog_ex("async log: thread pool doesn't exist anymore");
+    }
+}
+
+// send the format string and the raw args to the thread pool
+SPDLOG_INLINE void spdlog::async_logger::sink_deferred_(
+    const details::log_msg &msg, details::deferred_format_fn format_fn, size_t fmt_size)
+{
+    if (auto pool_ptr = thread_pool_.lock())
+    {
+        pool_ptr->post_deferred(this, msg, format_fn, fmt_size, overflow_policy_);
     }
     else
     {
@@ -36,6 +113,11 @@ SPDLOG_INLINE void spdlog::async_logger::sink_it_(const details::log_msg &msg)
     }
 }
 
+SPDLOG_INLINE void spdlog::async_logger::set_deferred_formatting(bool enabled)
+{
+    deferred_formatting_.store(enabled, std::memory_order_relaxed);
+}
+
 // send flush request to the thread pool
 SPDLOG_INLINE void spdlog::async_logger::flush_()
 {
@@ -73,7 +155,7 @@ SPDLOG_INLINE void spdlog::async_logger::flush_()
 
     if (auto pool_ptr = thread_pool_.lock())
     {
-        pool_ptr->post_flush(shared_from_this(), overflow_policy_);
+        pool_ptr->post_flush(this, overflow_policy_);
     }
     else
     {
@@ -81,32 +163,118 @@ SPDLOG_INLINE void spdlog::async_logger::flush_()
     }
 }
 
+SPDLOG_INLINE std::future<bool> spdlog::async_logger::flush_async()
+{
+    auto completion = details::make_unique<details::flush_completion>();
+    auto result = completion->get_future();
+    SPDLOG_TRY
+    {
+        if (auto pool_ptr = thread_pool_.lock())
+        {
+            pool_ptr->post_flush(this, overflow_policy_, std::move(completion));
+        }
+        else
+        {
+            throw_spdlog_ex("async flush: thread pool doesn't exist anymore");
+        }
+    }
+    SPDLOG_LOGGER_CATCH()
+    return result;
+}
+
+SPDLOG_INLINE bool spdlog::async_logger::flush_and_wait(std::chrono::milliseconds timeout)
+{
+    auto result = flush_async();
+    return result.wait_for(timeout) == std::future_status::ready && result.get();
+}
+
 //
 // backend functions - called from the thread pool to do the actual job
 //
 SPDLOG_INLINE void spdlog::async_logger::backend_sink_it_(const details::log_msg &msg)
 {
-    for (auto &sink : sinks_)
+    details::sink_list::reader sinks(sinks_);
+    log_to_sinks_(sinks, msg);
+
+    if (should_flush_(msg))
+    {
+        backend_flush_();
+    }
+}
+
+// log a run of messages with one call per sink.
+// messages below a sink's level are filtered out for that sink only.
+// if some of the sinks share the formatting, the messages are logged one by one instead.
+SPDLOG_INLINE void spdlog::async_logger::backend_sink_batch_(const details::log_msg *msgs, size_t count)
+{
+    auto min_level = level::off;
+    bool flush_needed = false;
+    for (size_t i = 0; i < count; i++)
+    {
+        min_level = (std::min)(min_level, msgs[i].level);
+        flush_needed = flush_needed || should_flush_(msgs[i]);
+    }
+
+    details::sink_list::reader sinks(sinks_);
+    if (sinks_share_format_(sinks))
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            log_to_sinks_(sinks, msgs[i]);
+        }
+        if (flush_needed)
+        {
+            backend_flush_();
+        }
+        return;
+    }
+
+    std::vector<details::log_msg> filtered;
+    for (auto &sink : sinks)
     {
-        if (sink->should_log(msg.level))
+        SPDLOG_TRY
         {
-            SPDLOG_TRY
+            if (sink->should_log(min_level))
+            {
+                sink->log_batch(msgs, count);
+                continue;
+            }
+            filtered.clear();
+            for (size_t i = 0; i < count; i++)
+            {
+                if (sink->should_log(msgs[i].level))
+                {
+                    filtered.push_back(msgs[i]);
+                }
+            }
+            if (!filtered.empty())
             {
-                sink->log(msg);
+                sink->log_batch(filtered.data(), filtered.size());
             }
-            SPDLOG_LOGGER_CATCH()
         }
+        SPDLOG_LOGGER_CATCH()
     }
 
-    if (should_flush_(msg))
+    if (flush_needed)
     {
         backend_flush_();
     }
 }
 
+SPDLOG_INLINE bool spdlog::async_logger::backend_format_(details::async_msg &msg, memory_buf_t &scratch)
+{
+    SPDLOG_TRY
+    {
+        msg.format_deferred(scratch);
+        return true;
+    }
+    SPDLOG_LOGGER_CATCH()
+    return false;
+}
+
 SPDLOG_INLINE void spdlog::async_logger::backend_flush_()
 {
-    for (auto &sink : sinks_)
+    for (auto &sink : details::sink_list::reader(sinks_))
     {
         SPDLOG_TRY
         {
@@ -120,5 +288,6 @@ SPDLOG_INLINE std::shared_ptr<spdlog::logger> spdlog::async_logger::clone(std::s
 {
     auto cloned = std::make_shared<spdlog::async_logger>(*this);
     cloned->name_ = std::move(new_name);
+    cloned->name_hash_ = std::hash<std::string>()(cloned->name_);
     return cloned;
 }
@@ -16,18 +16,65 @@
 
 #include <spdlog/logger.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+
 namespace spdlog {
 
 // Async overflow policy - block by default.
 enum class async_overflow_policy
 {
-    block,         // Block until message can be enqueued
-    overrun_oldest // Discard oldest message in the queue if full when trying to
-                   // add new item.
+    block,          // Block until message can be enqueued
+    overrun_oldest, // Discard oldest message in the queue if full when trying to
+                    // add new item.
+    discard_new     // Discard the new message if the queue is full. never blocks
+                    // or waits for the queue lock on a full queue.
+};
+
+// Queue backend of the thread pool - mutex based by default.
+enum class async_queue_type
+{
+    blocking,           // mutex and condition variables guarded circular queue
+    lockfree,           // lock free ring
+    per_thread,         // ring per producer thread (thread_pool::per_thread_q_max_items each, at most q_max_items).
+                        // consumed round-robin
+    per_thread_ordered, // like per_thread, but the consumer merges the rings by message time
+    priority            // mutex guarded queue with a lane per severity band (sharing q_max_items): error and critical
+                        // messages overtake info/warn and debug/trace ones. flushes are taken before them all,
+                        // after the messages logged ahead of them
+};
+
+// How the thread pool workers share the messages - a single queue by default.
+enum class async_sharding
+{
+    none,     // one queue for all workers. with several workers, messages of a logger may be written out of order
+    by_logger // queue per worker. each logger is pinned to a worker by its name hash, so its messages keep their order
+};
+
+// How producers and workers wait for the queue (when it is full/empty) - blocking
+// for the blocking queue and adaptive for the other queue types by default.
+enum class async_wait_strategy
+{
+    blocking, // park on a condition variable right away
+    adaptive, // spin, then yield and only then park. producers notify only a parked worker
+    busy_spin // never park. lowest latency, but keeps a core busy per waiting thread - for dedicated cores
+};
+
+// What the thread pool does with the queued messages when shut down - process them all by default.
+enum class async_shutdown_policy
+{
+    drain,      // process all the queued messages
+    drain_until // process the queued messages until the shutdown timeout, then drop the rest
 };
 
 namespace details {
 class thread_pool;
+class logger_table;
+class flush_completion;
+struct async_msg;
 }
 
 class SPDLOG_API async_logger final : public std::enable_shared_from_this<async_logger>, public logger
@@ -40,7 +87,9 @@ public:
         async_overflow_policy overflow_policy = async_overflow_policy::block)
         : logger(std::move(logger_name), begin, end)
         , thread_pool_(std::move(tp))
+        , loggers_(loggers_of_(thread_pool_))
         , overflow_policy_(overflow_policy)
+        , name_hash_(std::hash<std::string>()(name_))
     {}
 
     async_logger(std::string logger_name, sinks_init_list sinks_list, std::weak_ptr<details::thread_pool> tp,
@@ -49,17 +98,47 @@ public:
     async_logger(std::string logger_name, sink_ptr single_sink, std::weak_ptr<details::thread_pool> tp,
         async_overflow_policy overflow_policy = async_overflow_policy::block);
 
+    // a copy is not registered with the thread pool until its first post
+    async_logger(const async_logger &other);
+
+    // doesn't wait for the messages this logger posted: a copy of it processes them
+    // (see details::logger_table)
+    ~async_logger() override;
+
     std::shared_ptr<logger> clone(std::string new_name) override;
 
+    // format messages in the thread pool instead of the calling thread.
+    // applies to runtime format strings with arithmetic args only, the rest is still formatted by the caller.
+    void set_deferred_formatting(bool enabled);
+
+    // request the thread pool to flush the sinks. the future becomes true once they were flushed,
+    // or false if the request was dropped (by the overflow policy) or could not be posted.
+    std::future<bool> flush_async();
+
+    // flush and wait for the sinks to be flushed. return false if failed or timed out.
+    // should not be called from the sinks (the worker thread would wait for itself).
+    bool flush_and_wait(std::chrono::milliseconds timeout);
+
 protected:
     void sink_it_(const details::log_msg &msg) override;
+    void sink_deferred_(const details::log_msg &msg, details::deferred_format_fn format_fn, size_t fmt_size) override;
     void flush_() override;
     void backend_sink_it_(const details::log_msg &incoming_log_msg);
+    void backend_sink_batch_(const details::log_msg *msgs, size_t count);
+    // format a deferred message. return false if failed (the error handler was called).
+    bool backend_format_(details::async_msg &msg, memory_buf_t &scratch);
     void backend_flush_();
 
 private:
     std::weak_ptr<details::thread_pool> thread_pool_;     // 为什么为弱指针
+    std::shared_ptr<details::logger_table> loggers_;      // of the thread pool
     async_overflow_policy overflow_policy_;
+    size_t name_hash_; // selects the worker queue in sharded thread pools
+    std::atomic<uint64_t> logger_id_{0}; // in loggers_, 0 until the first post
+
+    static std::shared_ptr<details::logger_table> loggers_of_(const std::weak_ptr<details::thread_pool> &tp);
+    // register this logger on its first post. it must be owned by a shared_ptr.
+    uint64_t registered_id_();
 };
 } // namespace spdlog
 
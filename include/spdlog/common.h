@@ -8,6 +8,7 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <initializer_list>
 #include <memory>
 #include <exception>
@@ -279,7 +280,96 @@ struct source_loc
     const char *funcname{nullptr};
 };
 
+// Structured field of a log message - logger.info("request done", kv("user", id), kv("latency_us", t)).
+// Carried typed in the log_msg, so each sink can serialize it natively.
+// Only refers to the key and string value - they must outlive the log call.
+enum class field_type
+{
+    int64,
+    uint64,
+    float64,
+    boolean,
+    string
+};
+
+struct field
+{
+    string_view_t key;
+    field_type type{field_type::string};
+    union
+    {
+        int64_t int64_value{0};
+        uint64_t uint64_value;
+        double float64_value;
+        bool bool_value;
+    };
+    string_view_t string_value;
+};
+
+inline field kv(string_view_t key, bool value)
+{
+    field f;
+    f.key = key;
+    f.type = field_type::boolean;
+    f.bool_value = value;
+    return f;
+}
+
+template<typename T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, int>::type = 0>
+inline field kv(string_view_t key, T value)
+{
+    field f;
+    f.key = key;
+    f.type = field_type::int64;
+    f.int64_value = static_cast<int64_t>(value);
+    return f;
+}
+
+template<typename T,
+    typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+inline field kv(string_view_t key, T value)
+{
+    field f;
+    f.key = key;
+    f.type = field_type::uint64;
+    f.uint64_value = static_cast<uint64_t>(value);
+    return f;
+}
+
+template<typename T, typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+inline field kv(string_view_t key, T value)
+{
+    field f;
+    f.key = key;
+    f.type = field_type::float64;
+    f.float64_value = static_cast<double>(value);
+    return f;
+}
+
+template<typename T, typename std::enable_if<std::is_convertible<const T &, string_view_t>::value, int>::type = 0>
+inline field kv(string_view_t key, const T &value)
+{
+    field f;
+    f.key = key;
+    f.type = field_type::string;
+    f.string_value = string_view_t{value};
+    return f;
+}
+
 namespace details {
+// true if all the (one or more) types are structured fields
+template<typename... Ts>
+struct are_fields : std::false_type
+{};
+
+template<typename T>
+struct are_fields<T> : std::is_same<typename std::decay<T>::type, field>
+{};
+
+template<typename T, typename U, typename... Ts>
+struct are_fields<T, U, Ts...> : std::integral_constant<bool, are_fields<T>::value && are_fields<U, Ts...>::value>
+{};
+
 // make_unique support for pre c++14
 
 #if __cplusplus >= 201402L // C++14 and beyond
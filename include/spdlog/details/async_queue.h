@@ -0,0 +1,113 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Common interface of the queues the thread pool can be backed with.
+// enqueue(..) - will block until room found to put the new message.
+// enqueue_nowait(..) - will overrun the oldest message if no room left in
+// the queue. returns the number of messages lost.
+// try_enqueue(..) - will return false (leaving the item untouched) if no room
+// left in the queue.
+// dequeue_for(..) - will block until the queue is not empty or timeout have
+// passed.
+// dequeue_bulk(..) - like dequeue_for(..), but pops up to max_items at once.
+// wait_dequeued(..) - will block until all the items enqueued before the call
+// were dequeued (or overrun), or the deadline have passed.
+// for_each_unsafe(..) - visits the items in the queue without blocking or
+// allocating (for crash handlers). items pushed/popped meanwhile may be torn.
+//
+// How the blocking calls wait is set by the wait_policy the queue was created with.
+
+#include <chrono>
+#include <cstddef>
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace spdlog {
+namespace details {
+
+template<typename T>
+class async_queue
+{
+public:
+    using item_type = T;
+
+    virtual ~async_queue() = default;
+
+    virtual void enqueue(T &&item) = 0;
+    virtual size_t enqueue_nowait(T &&item) = 0;
+    virtual bool try_enqueue(T &&item) = 0;
+    virtual bool dequeue_for(T &popped_item, std::chrono::milliseconds wait_duration) = 0;
+    // Return number of items moved to popped_items (0 if timeout have passed)
+    virtual size_t dequeue_bulk(T *popped_items, size_t max_items, std::chrono::milliseconds wait_duration) = 0;
+    // Return false if the deadline have passed first
+    virtual bool wait_dequeued(std::chrono::steady_clock::time_point deadline) = 0;
+    virtual size_t overrun_counter() = 0;
+    virtual size_t size() = 0;
+    virtual void for_each_unsafe(void (*fun)(const T &item, void *ctx), void *ctx) = 0;
+};
+
+// hint the cpu that we are in a spin-wait loop
+inline void cpu_relax()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// how a producer/consumer waits for the queue: spin, then yield and only then
+// park on a condition variable (the other side notifies only parked waiters).
+struct wait_policy
+{
+    unsigned int spin_rounds;
+    unsigned int yield_rounds;
+    bool park; // if false, never park - keep spinning
+
+    static wait_policy blocking()
+    {
+        return wait_policy{0, 0, true};
+    }
+
+    static wait_policy adaptive()
+    {
+        return wait_policy{64, 16, true};
+    }
+
+    static wait_policy busy_spin()
+    {
+        return wait_policy{0, 0, false};
+    }
+
+    // should the waiter still spin/yield in this round (rather than park)
+    bool spins(unsigned int round) const
+    {
+        return !park || round < spin_rounds + yield_rounds;
+    }
+
+    void backoff(unsigned int round) const
+    {
+        if (!park || round < spin_rounds)
+        {
+            cpu_relax();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    // while spinning, read the clock only once in a while
+    static bool timed_out(unsigned int round, std::chrono::steady_clock::time_point deadline)
+    {
+        return (round & 1023) == 1023 && std::chrono::steady_clock::now() >= deadline;
+    }
+};
+
+} // namespace details
+} // namespace spdlog
@@ -13,6 +13,10 @@ SPDLOG_INLINE backtracer::backtracer(const backtracer &other)
     std::lock_guard<std::mutex> lock(other.mutex_);
     enabled_ = other.enabled();
     messages_ = other.messages_;
+    if (enabled())
+    {
+        publish_();
+    }
 }
 
 SPDLOG_INLINE backtracer::backtracer(backtracer &&other) SPDLOG_NOEXCEPT
@@ -20,27 +24,45 @@ SPDLOG_INLINE backtracer::backtracer(backtracer &&other) SPDLOG_NOEXCEPT
     std::lock_guard<std::mutex> lock(other.mutex_);
     enabled_ = other.enabled();
     messages_ = std::move(other.messages_);
+    if (enabled())
+    {
+        publish_();
+    }
 }
 
 SPDLOG_INLINE backtracer &backtracer::operator=(backtracer other)
 {
     std::lock_guard<std::mutex> lock(mutex_);
+    withdraw_();
     enabled_ = other.enabled();
     messages_ = std::move(other.messages_);
+    if (enabled())
+    {
+        publish_();
+    }
     return *this;
 }
 
+SPDLOG_INLINE backtracer::~backtracer()
+{
+    withdraw_();
+}
+
 SPDLOG_INLINE void backtracer::enable(size_t size)
 {
     std::lock_guard<std::mutex> lock{mutex_};
+    // not walked by crash handlers while the ring is replaced
+    withdraw_();
     enabled_.store(true, std::memory_order_relaxed);
     messages_ = circular_q<log_msg_buffer>{size};
+    publish_();
 }
 
 SPDLOG_INLINE void backtracer::disable()
 {
     std::lock_guard<std::mutex> lock{mutex_};
     enabled_.store(false, std::memory_order_relaxed);
+    withdraw_();
 }
 
 SPDLOG_INLINE bool backtracer::enabled() const
@@ -65,6 +87,65 @@ SPDLOG_INLINE void backtracer::foreach_pop(std::function<void(const details::log
         messages_.pop_front();
     }
 }
+
+SPDLOG_INLINE void backtracer::for_each_unsafe(void (*fun)(const details::log_msg &msg, void *ctx), void *ctx) const
+{
+    if (!enabled())
+    {
+        return;
+    }
+    for (size_t i = 0, n = messages_.size(); i < n; i++)
+    {
+        fun(messages_.at(i), ctx);
+    }
+}
+
+SPDLOG_INLINE void backtracer::for_each_published_unsafe(void (*fun)(const details::log_msg &msg, void *ctx), void *ctx)
+{
+    auto *published = published_();
+    for (size_t i = 0; i < published_max; i++)
+    {
+        auto *tracer = published[i].load(std::memory_order_acquire);
+        if (tracer != nullptr)
+        {
+            tracer->for_each_unsafe(fun, ctx);
+        }
+    }
+}
+
+// zero initialized at load time - no guard, so it is safe to read from a signal handler
+SPDLOG_INLINE std::atomic<const backtracer *> *backtracer::published_()
+{
+    static std::atomic<const backtracer *> published[published_max];
+    return published;
+}
+
+// not published yet (withdraw_() is called before a republish)
+SPDLOG_INLINE void backtracer::publish_()
+{
+    auto *published = published_();
+    for (size_t i = 0; i < published_max; i++)
+    {
+        const backtracer *expected = nullptr;
+        if (published[i].compare_exchange_strong(expected, this, std::memory_order_release))
+        {
+            return;
+        }
+    }
+}
+
+SPDLOG_INLINE void backtracer::withdraw_()
+{
+    auto *published = published_();
+    for (size_t i = 0; i < published_max; i++)
+    {
+        const backtracer *expected = this;
+        if (published[i].compare_exchange_strong(expected, nullptr, std::memory_order_release))
+        {
+            return;
+        }
+    }
+}
 } // namespace details
 } // namespace spdlog
 
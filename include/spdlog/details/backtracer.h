@@ -31,6 +31,7 @@ public:
 
     backtracer(backtracer &&other) SPDLOG_NOEXCEPT;
     backtracer &operator=(backtracer other);
+    ~backtracer();
 
     void enable(size_t size);
     void disable();
@@ -39,6 +40,20 @@ public:
 
     // pop all items in the q and apply the given fun on each of them.
     void foreach_pop(std::function<void(const details::log_msg &)> fun);
+
+    // visit the messages without locking, popping or allocating (for crash handlers)
+    void for_each_unsafe(void (*fun)(const details::log_msg &msg, void *ctx), void *ctx) const;
+
+    // visit the messages of every enabled backtracer the same way. the backtracers
+    // publish themselves in a fixed table of atomics while enabled (the ones that
+    // did not fit are skipped), so no lock is taken and nothing is owned.
+    static void for_each_published_unsafe(void (*fun)(const details::log_msg &msg, void *ctx), void *ctx);
+
+private:
+    static const size_t published_max = 256;
+    static std::atomic<const backtracer *> *published_();
+    void publish_();
+    void withdraw_();
 };
 
 } // namespace details
@@ -0,0 +1,33 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef SPDLOG_HEADER_ONLY
+#include <spdlog/details/callsite.h>
+#endif
+
+#include <spdlog/details/registry.h>
+#include <spdlog/logger.h>
+
+namespace spdlog {
+namespace details {
+
+#if defined(_WIN32) && defined(SPDLOG_SHARED_LIB)
+SPDLOG_INLINE std::atomic<size_t> &level_epoch()
+{
+    return level_epoch_holder<>::epoch;
+}
+#endif
+
+// the epoch is read before the logger, so a change made meanwhile is seen by the next call
+SPDLOG_INLINE bool callsite::refresh_(level::level_enum lvl, size_t epoch)
+{
+    auto *default_logger = registry::instance().get_default_raw();
+    bool enabled = default_logger != nullptr && (default_logger->should_log(lvl) || default_logger->should_backtrace());
+    state_.store((epoch << 1) | (enabled ? 1 : 0), std::memory_order_relaxed);
+    return enabled;
+}
+
+} // namespace details
+} // namespace spdlog
@@ -0,0 +1,91 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Static state of a log statement (see the SPDLOG_<LEVEL> macros in spdlog.h).
+// Holds the file and line of the statement and whether the default logger handles
+// the statement's level, cached until the global level epoch changes.
+// Constant initialized (no guard variable) - the function name is passed at log time.
+//
+// The epoch is bumped whenever something that decides it changes - a logger's
+// level or backtrace (logger::set_level(), cfg::load_levels(), ...) or the
+// default logger. So a disabled statement costs two loads and a branch: no
+// function call, and its arguments are not evaluated.
+
+#include <spdlog/common.h>
+
+#include <atomic>
+
+namespace spdlog {
+namespace details {
+
+// a template, so that its static is shared by all the translation units (even header only)
+template<typename Tag = void>
+struct level_epoch_holder
+{
+    static std::atomic<size_t> epoch;
+};
+
+template<typename Tag>
+std::atomic<size_t> level_epoch_holder<Tag>::epoch{1};
+
+#if defined(_WIN32) && defined(SPDLOG_SHARED_LIB)
+// a dll and its users do not share template statics - use the dll's one
+SPDLOG_API std::atomic<size_t> &level_epoch();
+#else
+inline std::atomic<size_t> &level_epoch()
+{
+    return level_epoch_holder<>::epoch;
+}
+#endif
+
+class SPDLOG_API callsite
+{
+public:
+    SPDLOG_CONSTEXPR callsite(const char *filename, int line)
+        : filename_(filename)
+        , line_(line)
+        , state_(0)
+    {}
+
+    callsite(const callsite &) = delete;
+    callsite &operator=(const callsite &) = delete;
+
+    source_loc loc(const char *funcname) const
+    {
+        return source_loc{filename_, line_, funcname};
+    }
+
+    // return true if the default logger logs (or backtraces) messages of the given level
+    bool enabled(level::level_enum lvl)
+    {
+        auto epoch = level_epoch().load(std::memory_order_acquire);
+        auto state = state_.load(std::memory_order_relaxed);
+        if ((state & ~size_t(1)) == (epoch << 1))
+        {
+            return (state & 1) != 0;
+        }
+        return refresh_(lvl, epoch);
+    }
+
+    // make all the call sites check the logger again
+    static void invalidate_all()
+    {
+        level_epoch().fetch_add(1, std::memory_order_release);
+    }
+
+private:
+    const char *filename_;
+    int line_;
+    std::atomic<size_t> state_; // (epoch << 1) | enabled. 0 - not checked yet
+
+    bool refresh_(level::level_enum lvl, size_t epoch);
+};
+
+} // namespace details
+} // namespace spdlog
+
+#ifdef SPDLOG_HEADER_ONLY
+#include "callsite-inl.h"
+#endif
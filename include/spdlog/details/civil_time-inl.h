@@ -0,0 +1,164 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef SPDLOG_HEADER_ONLY
+#include <spdlog/details/civil_time.h>
+#endif
+
+#include <spdlog/details/os.h>
+
+namespace spdlog {
+namespace details {
+
+SPDLOG_INLINE std::tm civil_time::local(std::time_t time_tt) SPDLOG_NOEXCEPT
+{
+    zone_window *window = zone_window_();
+    if (window == nullptr)
+    {
+        return os::localtime(time_tt);
+    }
+    if (time_tt < window->begin || time_tt >= window->end)
+    {
+        update_window_(*window, time_tt);
+    }
+    std::tm tm = window->sample;
+    to_tm_(static_cast<long long>(time_tt) + window->offset, tm);
+    return tm;
+}
+
+SPDLOG_INLINE std::tm civil_time::utc(std::time_t time_tt) SPDLOG_NOEXCEPT
+{
+    // carries the platform specific fields (e.g. the zone name) of a UTC time
+    static const std::tm sample = os::gmtime(0);
+    std::tm tm = sample;
+    to_tm_(static_cast<long long>(time_tt), tm);
+    return tm;
+}
+
+SPDLOG_INLINE int civil_time::utc_minutes_offset(std::time_t time_tt) SPDLOG_NOEXCEPT
+{
+    zone_window *window = zone_window_();
+    if (window == nullptr)
+    {
+        return static_cast<int>(offset_of_(os::localtime(time_tt), time_tt) / 60);
+    }
+    if (time_tt < window->begin || time_tt >= window->end)
+    {
+        update_window_(*window, time_tt);
+    }
+    return static_cast<int>(window->offset / 60);
+}
+
+SPDLOG_INLINE civil_time::zone_window *civil_time::zone_window_()
+{
+#ifndef SPDLOG_NO_TLS
+    static thread_local zone_window window;
+    return &window;
+#else
+    return nullptr;
+#endif
+}
+
+// the window is the zone of time_tt up to a day behind and ahead of it - up to the
+// transitions on either side, if any.
+SPDLOG_INLINE void civil_time::update_window_(zone_window &window, std::time_t time_tt)
+{
+    window.sample = os::localtime(time_tt);
+    window.offset = offset_of_(window.sample, time_tt);
+    window.begin = find_edge_(window, time_tt, -sample_secs);
+    window.end = find_edge_(window, time_tt, sample_secs);
+}
+
+SPDLOG_INLINE bool civil_time::same_zone_(const zone_window &window, std::time_t time_tt)
+{
+    std::tm tm = os::localtime(time_tt);
+    return offset_of_(tm, time_tt) == window.offset && tm.tm_isdst == window.sample.tm_isdst;
+}
+
+// walk from time_tt in steps until the zone differs (or max_window_secs), then bisect
+// the last step for the transition
+SPDLOG_INLINE std::time_t civil_time::find_edge_(const zone_window &window, std::time_t time_tt, long step)
+{
+    std::time_t inside = time_tt;
+    for (long walked = 0; walked < max_window_secs; walked += sample_secs)
+    {
+        std::time_t next = inside + step;
+        if (!same_zone_(window, next))
+        {
+            return find_transition_(window, inside, next);
+        }
+        inside = next;
+    }
+    return inside;
+}
+
+// the transition between inside and outside: if outside is ahead, the first time in the
+// other zone (the end of the window), if behind, the first time in this zone (its begin)
+SPDLOG_INLINE std::time_t civil_time::find_transition_(const zone_window &window, std::time_t inside, std::time_t outside)
+{
+    while (outside - inside > 1 || inside - outside > 1)
+    {
+        std::time_t mid = inside + (outside - inside) / 2;
+        if (same_zone_(window, mid))
+        {
+            inside = mid;
+        }
+        else
+        {
+            outside = mid;
+        }
+    }
+    return outside > inside ? outside : inside;
+}
+
+SPDLOG_INLINE long civil_time::offset_of_(const std::tm &local_tm, std::time_t time_tt)
+{
+    long long local_secs = days_from_civil_(local_tm.tm_year + 1900LL, static_cast<unsigned>(local_tm.tm_mon + 1),
+                               static_cast<unsigned>(local_tm.tm_mday)) *
+                               86400 +
+                           local_tm.tm_hour * 3600 + local_tm.tm_min * 60 + local_tm.tm_sec;
+    return static_cast<long>(local_secs - static_cast<long long>(time_tt));
+}
+
+// http://howardhinnant.github.io/date_algorithms.html (civil_from_days)
+SPDLOG_INLINE void civil_time::to_tm_(long long secs, std::tm &tm)
+{
+    long long days = secs >= 0 ? secs / 86400 : (secs - 86399) / 86400;
+    long long secs_of_day = secs - days * 86400;
+
+    long long z = days + 719468;
+    long long era = (z >= 0 ? z : z - 146096) / 146097;
+    auto doe = static_cast<unsigned>(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long long y = static_cast<long long>(yoe) + era * 400;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    unsigned d = doy - (153 * mp + 2) / 5 + 1;
+    unsigned m = mp < 10 ? mp + 3 : mp - 9;
+    y += m <= 2 ? 1 : 0;
+
+    tm.tm_sec = static_cast<int>(secs_of_day % 60);
+    tm.tm_min = static_cast<int>(secs_of_day / 60 % 60);
+    tm.tm_hour = static_cast<int>(secs_of_day / 3600);
+    tm.tm_mday = static_cast<int>(d);
+    tm.tm_mon = static_cast<int>(m - 1);
+    tm.tm_year = static_cast<int>(y - 1900);
+    tm.tm_wday = static_cast<int>(days >= -4 ? (days + 4) % 7 : (days + 5) % 7 + 6);
+    tm.tm_yday = static_cast<int>(days - days_from_civil_(y, 1, 1));
+}
+
+// http://howardhinnant.github.io/date_algorithms.html (days_from_civil)
+SPDLOG_INLINE long long civil_time::days_from_civil_(long long y, unsigned m, unsigned d)
+{
+    y -= m <= 2 ? 1 : 0;
+    long long era = (y >= 0 ? y : y - 399) / 400;
+    auto yoe = static_cast<unsigned>(y - era * 400);
+    unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<long long>(doe) - 719468;
+}
+
+} // namespace details
+} // namespace spdlog
@@ -0,0 +1,67 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Broken down time computed arithmetically instead of by localtime_r/gmtime_r
+// (which take the libc timezone lock and may stat the zone file).
+// Each thread caches the local zone offset together with the interval it is valid
+// for - between the DST transitions around it, looked up at most a day behind and
+// ahead. Within the interval local() is lock free and constant time, os::localtime()
+// is only called to fill the cache. Changes of the system zone are picked up when
+// it expires.
+
+#include <spdlog/common.h>
+
+#include <ctime>
+
+namespace spdlog {
+namespace details {
+
+class SPDLOG_API civil_time
+{
+public:
+    // like os::localtime()
+    static std::tm local(std::time_t time_tt) SPDLOG_NOEXCEPT;
+
+    // like os::gmtime()
+    static std::tm utc(std::time_t time_tt) SPDLOG_NOEXCEPT;
+
+    // offset of the local time from UTC at the given time, in minutes
+    static int utc_minutes_offset(std::time_t time_tt) SPDLOG_NOEXCEPT;
+
+private:
+    // how far behind and ahead the DST transitions are looked up
+    static const long max_window_secs = 24 * 3600;
+    // the zone is sampled this often on either side - transitions closer together than
+    // this (back and forth) are not seen
+    static const long sample_secs = 3 * 3600;
+
+    // the local zone in [begin, end)
+    struct zone_window
+    {
+        std::time_t begin = 0;
+        std::time_t end = 0;
+        long offset = 0; // seconds
+        std::tm sample;  // a local time in the window - isdst, and the zone name/offset fields where available
+    };
+
+    // nullptr without thread local storage
+    static zone_window *zone_window_();
+    static void update_window_(zone_window &window, std::time_t time_tt);
+    static bool same_zone_(const zone_window &window, std::time_t time_tt);
+    static std::time_t find_edge_(const zone_window &window, std::time_t time_tt, long step);
+    static std::time_t find_transition_(const zone_window &window, std::time_t inside, std::time_t outside);
+    static long offset_of_(const std::tm &local_tm, std::time_t time_tt);
+
+    // fill the date/time fields of tm with the time of the given seconds since epoch
+    static void to_tm_(long long secs, std::tm &tm);
+    static long long days_from_civil_(long long y, unsigned m, unsigned d);
+};
+
+} // namespace details
+} // namespace spdlog
+
+#ifdef SPDLOG_HEADER_ONLY
+#include "civil_time-inl.h"
+#endif
@@ -0,0 +1,246 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef SPDLOG_HEADER_ONLY
+#include <spdlog/details/crash_handler.h>
+#endif
+
+#include <spdlog/details/backtracer.h>
+#include <spdlog/details/thread_pool.h>
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <exception>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+namespace spdlog {
+namespace details {
+
+struct crash_handler::state
+{
+    std::atomic<int> fd{-1};
+    std::atomic_flag dumped = ATOMIC_FLAG_INIT;
+    bool installed = false;
+    std::terminate_handler prev_terminate = nullptr;
+#ifdef _WIN32
+    void (*prev_handlers[signals_n])(int);
+#else
+    struct sigaction prev_actions[signals_n];
+#endif
+};
+
+SPDLOG_INLINE crash_handler::state &crash_handler::state_()
+{
+    static state s;
+    return s;
+}
+
+SPDLOG_INLINE int crash_handler::signal_(size_t index)
+{
+#ifdef _WIN32
+    static const int signals[signals_n] = {SIGSEGV, SIGFPE, SIGILL, SIGABRT};
+#else
+    static const int signals[signals_n] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+#endif
+    return signals[index];
+}
+
+SPDLOG_INLINE void crash_handler::install(int fd)
+{
+    auto &s = state_();
+    uninstall();
+    s.fd.store(fd);
+    s.dumped.clear();
+
+    for (size_t i = 0; i < signals_n; i++)
+    {
+#ifdef _WIN32
+        s.prev_handlers[i] = std::signal(signal_(i), &crash_handler::on_signal_);
+#else
+        struct sigaction action;
+        action.sa_handler = &crash_handler::on_signal_;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_ONSTACK; // runs on the alternate signal stack, if the thread has one
+        sigaction(signal_(i), &action, &s.prev_actions[i]);
+#endif
+    }
+    s.prev_terminate = std::set_terminate(&crash_handler::on_terminate_);
+    s.installed = true;
+}
+
+SPDLOG_INLINE void crash_handler::uninstall()
+{
+    auto &s = state_();
+    if (!s.installed)
+    {
+        return;
+    }
+    for (size_t i = 0; i < signals_n; i++)
+    {
+#ifdef _WIN32
+        std::signal(signal_(i), s.prev_handlers[i]);
+#else
+        sigaction(signal_(i), &s.prev_actions[i], nullptr);
+#endif
+    }
+    std::set_terminate(s.prev_terminate);
+    s.installed = false;
+    s.fd.store(-1);
+}
+
+SPDLOG_INLINE void crash_handler::dump(const char *reason)
+{
+    auto &s = state_();
+    int fd = s.fd.load();
+    if (fd < 0 || s.dumped.test_and_set())
+    {
+        return;
+    }
+
+    write_(fd, "*** crash handler: ");
+    write_(fd, reason);
+    write_(fd, " - pending log messages follow ***\n");
+    thread_pool::for_each_published_pending_unsafe(&crash_handler::write_pending_, &fd);
+    backtracer::for_each_published_unsafe(&crash_handler::write_backtrace_, &fd);
+    write_(fd, "*** crash handler: end of dump ***\n");
+}
+
+SPDLOG_INLINE void crash_handler::on_signal_(int sig)
+{
+    auto &s = state_();
+    const char *reason = "fatal signal";
+    for (size_t i = 0; i < signals_n; i++)
+    {
+        if (signal_(i) != sig)
+        {
+            continue;
+        }
+        switch (sig)
+        {
+        case SIGSEGV:
+            reason = "SIGSEGV";
+            break;
+        case SIGFPE:
+            reason = "SIGFPE";
+            break;
+        case SIGILL:
+            reason = "SIGILL";
+            break;
+        case SIGABRT:
+            reason = "SIGABRT";
+            break;
+        default:
+            reason = "SIGBUS";
+            break;
+        }
+        dump(reason);
+
+        // let the previous handler (or the default action) take it from here
+#ifdef _WIN32
+        std::signal(sig, s.prev_handlers[i] != SIG_ERR ? s.prev_handlers[i] : SIG_DFL);
+#else
+        sigaction(sig, &s.prev_actions[i], nullptr);
+#endif
+        std::raise(sig);
+        return;
+    }
+}
+
+SPDLOG_INLINE void crash_handler::on_terminate_()
+{
+    dump("std::terminate");
+    auto prev = state_().prev_terminate;
+    if (prev != nullptr)
+    {
+        prev();
+    }
+    std::abort();
+}
+
+SPDLOG_INLINE void crash_handler::write_(int fd, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+#ifdef _WIN32
+        auto n = ::_write(fd, data, static_cast<unsigned int>(size));
+#else
+        auto n = ::write(fd, data, size);
+#endif
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+SPDLOG_INLINE void crash_handler::write_(int fd, string_view_t str)
+{
+    write_(fd, str.data(), str.size());
+}
+
+SPDLOG_INLINE void crash_handler::write_uint_(int fd, size_t value)
+{
+    char buf[24];
+    size_t pos = sizeof(buf);
+    do
+    {
+        buf[--pos] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    write_(fd, buf + pos, sizeof(buf) - pos);
+}
+
+// [tag] [logger] [level] [thread id] payload
+SPDLOG_INLINE void crash_handler::write_msg_(int fd, const char *tag, const log_msg &msg, size_t payload_size)
+{
+    write_(fd, "[");
+    write_(fd, tag);
+    write_(fd, "] [");
+    write_(fd, msg.logger_name);
+    write_(fd, "] [");
+    write_(fd, level::to_string_view(msg.level));
+    write_(fd, "] [");
+    write_uint_(fd, msg.thread_id);
+    write_(fd, "] ");
+    write_(fd, msg.payload.data(), payload_size < msg.payload.size() ? payload_size : msg.payload.size());
+    write_(fd, "\n");
+}
+
+SPDLOG_INLINE void crash_handler::write_pending_(const async_msg &msg, void *ctx)
+{
+    if (msg.msg_type != async_msg_type::log)
+    {
+        return;
+    }
+    int fd = *static_cast<int *>(ctx);
+    if (msg.format_fn != nullptr)
+    {
+        // the args are still raw bytes. write the format string only
+        write_msg_(fd, "pending, unformatted", msg, msg.format_size);
+        return;
+    }
+    write_msg_(fd, "pending", msg, msg.payload.size());
+}
+
+SPDLOG_INLINE void crash_handler::write_backtrace_(const log_msg &msg, void *ctx)
+{
+    write_msg_(*static_cast<int *>(ctx), "backtrace", msg, msg.payload.size());
+}
+} // namespace details
+} // namespace spdlog
@@ -0,0 +1,67 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Opt-in crash handler for async logging.
+// On fatal signals (SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT) and std::terminate
+// it writes the messages still queued in the thread pools (and the batches their
+// workers took last) and the backtrace rings of the loggers to a preopened file
+// descriptor, and then lets the previous handler run.
+//
+// The pools, their per thread rings and the backtracers publish raw pointers to
+// themselves in fixed tables of atomics while they are alive, and the dump walks
+// those tables: no lock is taken, nothing is owned or allocated and only write(2)
+// is called. The queued messages keep the logger name and the payload in their
+// own flat buffer, so they are written as is.
+// The dump is best effort - messages being pushed or popped during the crash
+// may be torn, and a batch taken by a worker may have been written already.
+// Deferred messages are written with their format string only.
+
+#include <spdlog/common.h>
+
+namespace spdlog {
+namespace details {
+struct async_msg;
+struct log_msg;
+
+class SPDLOG_API crash_handler
+{
+public:
+    // install the handlers. the dump is written to fd.
+    static void install(int fd);
+
+    // restore the previous handlers
+    static void uninstall();
+
+    // write the dump to fd (once). called by the handlers.
+    static void dump(const char *reason);
+
+private:
+#ifdef _WIN32
+    static const size_t signals_n = 4;
+#else
+    static const size_t signals_n = 5;
+#endif
+
+    struct state;
+    static state &state_();
+    static int signal_(size_t index);
+
+    static void on_signal_(int sig);
+    static void on_terminate_();
+
+    static void write_(int fd, const char *data, size_t size);
+    static void write_(int fd, string_view_t str);
+    static void write_uint_(int fd, size_t value);
+    static void write_msg_(int fd, const char *tag, const log_msg &msg, size_t payload_size);
+    static void write_pending_(const async_msg &msg, void *ctx);
+    static void write_backtrace_(const log_msg &msg, void *ctx);
+};
+
+} // namespace details
+} // namespace spdlog
+
+#ifdef SPDLOG_HEADER_ONLY
+#include "crash_handler-inl.h"
+#endif
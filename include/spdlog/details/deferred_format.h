@@ -0,0 +1,121 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Support for deferred formatting (async loggers).
+// The format string and the arguments are copied as raw bytes into the
+// message payload, and formatted later (by the thread pool) using the
+// format function of the argument types:
+//
+//   payload: [format string][arg1 bytes][arg2 bytes]...
+//
+// Only arithmetic arguments are deferred - anything that may point to the
+// caller's memory (strings, pointers, user types) is formatted eagerly.
+
+#include <spdlog/common.h>
+
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+
+namespace spdlog {
+namespace details {
+
+// format the args stored after the format string into dest
+using deferred_format_fn = void (*)(string_view_t fmt, const char *args, memory_buf_t &dest);
+
+template<size_t... Is>
+struct index_sequence
+{};
+
+template<size_t N, size_t... Is>
+struct make_index_sequence : make_index_sequence<N - 1, N - 1, Is...>
+{};
+
+template<size_t... Is>
+struct make_index_sequence<0, Is...>
+{
+    using type = index_sequence<Is...>;
+};
+
+template<typename... Args>
+struct all_arithmetic : std::true_type
+{};
+
+template<typename Arg, typename... Args>
+struct all_arithmetic<Arg, Args...>
+    : std::integral_constant<bool, std::is_arithmetic<typename std::decay<Arg>::type>::value && all_arithmetic<Args...>::value>
+{};
+
+template<typename... Args>
+struct deferred_args
+{
+    using values_type = std::tuple<typename std::decay<Args>::type...>;
+
+    static const bool eligible = sizeof...(Args) > 0 && all_arithmetic<Args...>::value;
+
+    static size_t size()
+    {
+        return size_of_<typename std::decay<Args>::type...>();
+    }
+
+    static void store(char *dest, const Args &... args)
+    {
+        store_(dest, args...);
+    }
+
+    static void format(string_view_t fmt, const char *args, memory_buf_t &dest)
+    {
+        // braced init lists are evaluated left to right, so the args are read in order
+        reader r{args};
+        values_type values{r.template read<typename std::decay<Args>::type>()...};
+        format_(fmt, values, dest, typename make_index_sequence<sizeof...(Args)>::type{});
+    }
+
+private:
+    struct reader
+    {
+        const char *pos;
+
+        template<typename T>
+        T read()
+        {
+            T value;
+            std::memcpy(&value, pos, sizeof(T));
+            pos += sizeof(T);
+            return value;
+        }
+    };
+
+    template<typename... Ts>
+    static typename std::enable_if<sizeof...(Ts) == 0, size_t>::type size_of_()
+    {
+        return 0;
+    }
+
+    template<typename T, typename... Ts>
+    static size_t size_of_()
+    {
+        return sizeof(T) + size_of_<Ts...>();
+    }
+
+    static void store_(char *) {}
+
+    template<typename T, typename... Ts>
+    static void store_(char *dest, const T &value, const Ts &... rest)
+    {
+        typename std::decay<T>::type v = value;
+        std::memcpy(dest, &v, sizeof(v));
+        store_(dest + sizeof(v), rest...);
+    }
+
+    template<size_t... Is>
+    static void format_(string_view_t fmt, const values_type &values, memory_buf_t &dest, index_sequence<Is...>)
+    {
+        fmt::format_to(dest, fmt, std::get<Is>(values)...);
+    }
+};
+
+} // namespace details
+} // namespace spdlog
@@ -3,10 +3,17 @@
 #pragma once
 
 #include <chrono>
+#include <cstring>
+#include <ctime>
 #include <type_traits>
 #include <spdlog/fmt/fmt.h>
 #include <spdlog/common.h>
 
+#if !defined(SPDLOG_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SPDLOG_FMT_HELPER_SSE2
+#include <emmintrin.h>
+#endif
+
 // Some fmt helpers to efficiently format and pad ints and strings
 namespace spdlog {
 namespace details {
@@ -45,12 +52,22 @@ inline unsigned int count_digits(T n)
         ::count_digits(static_cast<count_type>(n)));
 }
 
+// the two digits of n (0-99)
+inline const char *digits2(size_t n)
+{
+    return &"0001020304050607080910111213141516171819"
+            "2021222324252627282930313233343536373839"
+            "4041424344454647484950515253545556575859"
+            "6061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899"[n * 2];
+}
+
 inline void pad2(int n, memory_buf_t &dest)
 {
     if (n >= 0 && n < 100) // 0-99
     {
-        dest.push_back(static_cast<char>('0' + n / 10));
-        dest.push_back(static_cast<char>('0' + n % 10));
+        const char *digits = digits2(static_cast<size_t>(n));
+        dest.append(digits, digits + 2);
     }
     else // unlikely, but just in case, let fmt deal with it
     {
@@ -58,13 +75,34 @@ inline void pad2(int n, memory_buf_t &dest)
     }
 }
 
+// write n as exactly width digits (zero padded) to out - in place of a field of fixed size
+template<typename T>
+inline void write_padded(T n, size_t width, char *out)
+{
+    static_assert(std::is_unsigned<T>::value, "write_padded must get unsigned T");
+    for (; width >= 2; width -= 2)
+    {
+        std::memcpy(out + width - 2, digits2(static_cast<size_t>(n % 100)), 2);
+        n /= 100;
+    }
+    if (width == 1)
+    {
+        out[0] = static_cast<char>('0' + n % 10);
+    }
+}
+
 template<typename T>
 inline void pad_uint(T n, unsigned int width, memory_buf_t &dest)
 {
     static_assert(std::is_unsigned<T>::value, "pad_uint must get unsigned T");
-    for (auto digits = count_digits(n); digits < width; digits++)
+    auto digits = count_digits(n);
+    if (digits <= width && width <= 20)
     {
-        dest.push_back('0');
+        // one append of the padded digits
+        char buf[20];
+        write_padded(n, width, buf);
+        dest.append(buf, buf + width);
+        return;
     }
     append_int(n, dest);
 }
@@ -75,10 +113,9 @@ inline void pad3(T n, memory_buf_t &dest)
     static_assert(std::is_unsigned<T>::value, "pad3 must get unsigned T");
     if (n < 1000)
     {
-        dest.push_back(static_cast<char>(n / 100 + '0'));
-        n = n % 100;
-        dest.push_back(static_cast<char>((n / 10) + '0'));
-        dest.push_back(static_cast<char>((n % 10) + '0'));
+        char buf[3];
+        write_padded(n, 3, buf);
+        dest.append(buf, buf + 3);
     }
     else
     {
@@ -98,6 +135,59 @@ inline void pad9(T n, memory_buf_t &dest)
     pad_uint(n, 9, dest);
 }
 
+// size of the buffer of write_datetime()
+static const size_t datetime_buf_size = 32;
+
+// write "YYYY-MM-DD HH:MM:SS.nnnnnnnnn" (29 chars) to out, a buffer of datetime_buf_size bytes.
+// the year must be in the 0-9999 range and nanos < 1000000000.
+// the 16 two digit groups are converted at once with SSE2 where available.
+inline void write_datetime(const std::tm &tm_time, uint32_t nanos, char *out)
+{
+    auto year = static_cast<uint32_t>(tm_time.tm_year + 1900);
+    uint32_t groups[16] = {year / 100, year % 100, static_cast<uint32_t>(tm_time.tm_mon + 1), static_cast<uint32_t>(tm_time.tm_mday),
+        static_cast<uint32_t>(tm_time.tm_hour), static_cast<uint32_t>(tm_time.tm_min), static_cast<uint32_t>(tm_time.tm_sec),
+        nanos / 10000000, nanos / 100000 % 100, nanos / 1000 % 100, nanos / 10 % 100, nanos % 10 * 10, 0, 0, 0, 0};
+
+    // the digits of the groups, in order
+    char pairs[32];
+#ifdef SPDLOG_FMT_HELPER_SSE2
+    const __m128i ten = _mm_set1_epi16(10);
+    const __m128i div10 = _mm_set1_epi16(6554); // (n * 6554) >> 16 == n / 10 for n < 100
+    const __m128i zeros = _mm_set1_epi8('0');
+    for (size_t i = 0; i < 2; i++)
+    {
+        const uint32_t *g = groups + i * 8;
+        __m128i n = _mm_set_epi16(static_cast<short>(g[7]), static_cast<short>(g[6]), static_cast<short>(g[5]), static_cast<short>(g[4]),
+            static_cast<short>(g[3]), static_cast<short>(g[2]), static_cast<short>(g[1]), static_cast<short>(g[0]));
+        __m128i tens = _mm_mulhi_epu16(n, div10);
+        __m128i ones = _mm_sub_epi16(n, _mm_mullo_epi16(tens, ten));
+        // little endian - the tens digit is the first byte of each group
+        __m128i digits = _mm_add_epi8(_mm_or_si128(tens, _mm_slli_epi16(ones, 8)), zeros);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(pairs + i * 16), digits);
+    }
+#else
+    for (size_t i = 0; i < 16; i++)
+    {
+        std::memcpy(pairs + i * 2, digits2(groups[i]), 2);
+    }
+#endif
+
+    std::memcpy(out, pairs, 4); // YYYY
+    out[4] = '-';
+    std::memcpy(out + 5, pairs + 4, 2); // MM
+    out[7] = '-';
+    std::memcpy(out + 8, pairs + 6, 2); // DD
+    out[10] = ' ';
+    std::memcpy(out + 11, pairs + 8, 2); // HH
+    out[13] = ':';
+    std::memcpy(out + 14, pairs + 10, 2); // MM
+    out[16] = ':';
+    std::memcpy(out + 17, pairs + 12, 2); // SS
+    out[19] = '.';
+    std::memcpy(out + 20, pairs + 14, 10); // nnnnnnnnn + padding
+    std::memset(out + 30, 0, datetime_buf_size - 30);
+}
+
 // return fraction of a second of the given time_point.
 // e.g.
 // fraction<std::milliseconds>(tp) -> will return the millis part of the second
@@ -111,6 +201,83 @@ inline ToDuration time_fraction(log_clock::time_point tp)
     return duration_cast<ToDuration>(duration) - duration_cast<ToDuration>(secs);
 }
 
+// string field values with spaces, quotes or '=' (or empty) are quoted
+inline void append_field_string(spdlog::string_view_t value, memory_buf_t &dest)
+{
+    bool quote = value.size() == 0;
+    for (auto ch : value)
+    {
+        if (ch == ' ' || ch == '"' || ch == '=' || ch == '\\' || ch == '\n')
+        {
+            quote = true;
+            break;
+        }
+    }
+    if (!quote)
+    {
+        append_string_view(value, dest);
+        return;
+    }
+    dest.push_back('"');
+    for (auto ch : value)
+    {
+        if (ch == '"' || ch == '\\')
+        {
+            dest.push_back('\\');
+        }
+        if (ch == '\n')
+        {
+            dest.push_back('\\');
+            ch = 'n';
+        }
+        dest.push_back(ch);
+    }
+    dest.push_back('"');
+}
+
+// the value of a structured field as text, strings as they are
+inline void append_field_value(const field &f, memory_buf_t &dest)
+{
+    switch (f.type)
+    {
+    case field_type::int64:
+        append_int(f.int64_value, dest);
+        break;
+    case field_type::uint64:
+        append_int(f.uint64_value, dest);
+        break;
+    case field_type::float64:
+        fmt::format_to(dest, "{}", f.float64_value);
+        break;
+    case field_type::boolean:
+        append_string_view(f.bool_value ? "true" : "false", dest);
+        break;
+    case field_type::string:
+        append_string_view(f.string_value, dest);
+        break;
+    }
+}
+
+// the text form of structured fields: " key=value key=value.."
+inline void append_fields(const field *fields, size_t fields_n, memory_buf_t &dest)
+{
+    for (size_t i = 0; i < fields_n; i++)
+    {
+        const auto &f = fields[i];
+        dest.push_back(' ');
+        append_string_view(f.key, dest);
+        dest.push_back('=');
+        if (f.type == field_type::string)
+        {
+            append_field_string(f.string_value, dest);
+        }
+        else
+        {
+            append_field_value(f, dest);
+        }
+    }
+}
+
 } // namespace fmt_helper
 } // namespace details
 } // namespace spdlog
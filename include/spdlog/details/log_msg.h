@@ -27,6 +27,10 @@ struct SPDLOG_API log_msg
 
     source_loc source;
     string_view_t payload;
+
+    // structured fields (see spdlog::kv()), if any
+    const field *fields{nullptr};
+    size_t fields_n{0};
 };
 } // namespace details
 } // namespace spdlog
@@ -7,6 +7,9 @@
 #include <spdlog/details/log_msg_buffer.h>
 #endif
 
+#include <cstdint>
+#include <cstring>
+
 namespace spdlog {
 namespace details {
 
@@ -15,6 +18,7 @@ SPDLOG_INLINE log_msg_buffer::log_msg_buffer(const log_msg &orig_msg)
 {
     buffer.append(logger_name.begin(), logger_name.end());
     buffer.append(payload.begin(), payload.end());
+    copy_fields(orig_msg);
     update_string_views();
 }
 
@@ -23,6 +27,7 @@ SPDLOG_INLINE log_msg_buffer::log_msg_buffer(const log_msg_buffer &other)
 {
     buffer.append(logger_name.begin(), logger_name.end());
     buffer.append(payload.begin(), payload.end());
+    copy_fields(other);
     update_string_views();
 }
 
@@ -42,18 +47,121 @@ SPDLOG_INLINE log_msg_buffer &log_msg_buffer::operator=(const log_msg_buffer &ot
     return *this;
 }
 
+// keep our own allocation if the other's data fits in it, so moving messages
+// in and out of preallocated queue slots does not free or allocate memory.
+// (with room to realign the fields - a stolen or same-sized buffer stays aligned)
 SPDLOG_INLINE log_msg_buffer &log_msg_buffer::operator=(log_msg_buffer &&other) SPDLOG_NOEXCEPT
 {
     log_msg::operator=(other);
-    buffer = std::move(other.buffer);
+    if (other.buffer.size() + alignof(field) - 1 <= buffer.capacity())
+    {
+        buffer.clear();
+        buffer.append(other.buffer.data(), other.buffer.data() + other.buffer.size());
+    }
+    else
+    {
+        buffer = std::move(other.buffer);
+    }
+    update_string_views();
+    return *this;
+}
+
+SPDLOG_INLINE log_msg_buffer &log_msg_buffer::operator=(const log_msg &orig_msg)
+{
+    auto *fields_at = reinterpret_cast<const char *>(orig_msg.fields);
+    if (orig_msg.fields_n > 0 && fields_at >= buffer.data() && fields_at < buffer.data() + buffer.size())
+    {
+        // the fields (and their strings) are ours - copy them aside first
+        log_msg_buffer copy(orig_msg);
+        return *this = std::move(copy);
+    }
+    log_msg::operator=(orig_msg);
+    buffer.clear();
+    buffer.append(logger_name.begin(), logger_name.end());
+    buffer.append(payload.begin(), payload.end());
+    copy_fields(orig_msg);
     update_string_views();
     return *this;
 }
 
+// append the keys and string values of the fields to the buffer (after the payload),
+// then the fields, aligned.
+SPDLOG_INLINE void log_msg_buffer::copy_fields(const log_msg &orig_msg)
+{
+    fields_n = orig_msg.fields_n;
+    if (fields_n == 0)
+    {
+        return;
+    }
+    size_t strings_size = 0;
+    for (size_t i = 0; i < fields_n; i++)
+    {
+        strings_size += orig_msg.fields[i].key.size() + orig_msg.fields[i].string_value.size();
+    }
+    // one allocation at most, so the alignment below holds
+    buffer.reserve(buffer.size() + strings_size + alignof(field) - 1 + fields_n * sizeof(field));
+    for (size_t i = 0; i < fields_n; i++)
+    {
+        const field &f = orig_msg.fields[i];
+        buffer.append(f.key.begin(), f.key.end());
+        buffer.append(f.string_value.begin(), f.string_value.end());
+    }
+    auto misaligned = reinterpret_cast<std::uintptr_t>(buffer.data() + buffer.size()) % alignof(field);
+    buffer.resize(buffer.size() + (misaligned == 0 ? 0 : alignof(field) - misaligned));
+    auto *raw = reinterpret_cast<const char *>(orig_msg.fields);
+    buffer.append(raw, raw + fields_n * sizeof(field));
+}
+
+// the bytes of the buffer may have been copied to an address aligned differently -
+// move the fields to the first aligned place after their strings.
+SPDLOG_INLINE void log_msg_buffer::align_fields()
+{
+    size_t fields_size = fields_n * sizeof(field);
+    if (reinterpret_cast<std::uintptr_t>(buffer.data() + buffer.size() - fields_size) % alignof(field) == 0)
+    {
+        return;
+    }
+    size_t strings_end = logger_name.size() + payload.size();
+    for (size_t i = 0; i < fields_n; i++)
+    {
+        field f;
+        std::memcpy(&f, buffer.data() + buffer.size() - fields_size + i * sizeof(field), sizeof(field));
+        strings_end += f.key.size() + f.string_value.size();
+    }
+    size_t old_size = buffer.size();
+    buffer.reserve(strings_end + alignof(field) - 1 + fields_size);
+    auto misaligned = reinterpret_cast<std::uintptr_t>(buffer.data() + strings_end) % alignof(field);
+    size_t fields_pos = strings_end + (misaligned == 0 ? 0 : alignof(field) - misaligned);
+    if (fields_pos + fields_size > old_size)
+    {
+        buffer.resize(fields_pos + fields_size);
+    }
+    std::memmove(buffer.data() + fields_pos, buffer.data() + old_size - fields_size, fields_size);
+    buffer.resize(fields_pos + fields_size);
+}
+
 SPDLOG_INLINE void log_msg_buffer::update_string_views()
 {
     logger_name = string_view_t{buffer.data(), logger_name.size()};
     payload = string_view_t{buffer.data() + logger_name.size(), payload.size()};
+    if (fields_n == 0)
+    {
+        fields = nullptr;
+        return;
+    }
+
+    align_fields();
+    auto *buffer_fields = reinterpret_cast<field *>(buffer.data() + buffer.size() - fields_n * sizeof(field));
+    auto pos = logger_name.size() + payload.size();
+    for (size_t i = 0; i < fields_n; i++)
+    {
+        field &f = buffer_fields[i];
+        f.key = string_view_t{buffer.data() + pos, f.key.size()};
+        pos += f.key.size();
+        f.string_value = string_view_t{buffer.data() + pos, f.string_value.size()};
+        pos += f.string_value.size();
+    }
+    fields = buffer_fields;
 }
 
 } // namespace details
@@ -10,10 +10,14 @@ namespace details {
 
 // Extend log_msg with internal buffer to store its payload.
 // This is needed since log_msg holds string_views that points to stack data.
+// The structured fields are copied to the buffer too - their strings after the payload,
+// then the field array itself (aligned) at the end of the buffer.
 
 class SPDLOG_API log_msg_buffer : public log_msg
 {
     memory_buf_t buffer;
+    void copy_fields(const log_msg &orig_msg);
+    void align_fields();
     void update_string_views();
 
 public:
@@ -23,6 +27,8 @@ public:
     log_msg_buffer(log_msg_buffer &&other) SPDLOG_NOEXCEPT;
     log_msg_buffer &operator=(const log_msg_buffer &other);
     log_msg_buffer &operator=(log_msg_buffer &&other) SPDLOG_NOEXCEPT;
+    // copy orig_msg's strings into the existing buffer (reusing its capacity)
+    log_msg_buffer &operator=(const log_msg &orig_msg);
 };
 
 } // namespace details
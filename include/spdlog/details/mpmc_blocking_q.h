@@ -5,26 +5,35 @@
 
 // multi producer-multi consumer blocking queue.
 // enqueue(..) - will block until room found to put the new message.
-// enqueue_nowait(..) - will return immediately with false if no room left in
+// enqueue_nowait(..) - will overrun the oldest message if no room left in
+// the queue.
+// try_enqueue(..) - will return immediately with false if no room left in
 // the queue.
 // dequeue_for(..) - will block until the queue is not empty or timeout have
 // passed.
+// With a spinning wait policy the waiters poll the queue (releasing the mutex
+// between the polls) before they wait on the condition variables. The condition
+// variables are notified only when someone waits on them.
 
+#include <spdlog/details/async_queue.h>
 #include <spdlog/details/circular_q.h>
 
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
+#include <thread>
 
 namespace spdlog {
 namespace details {
 
 template<typename T>
-class mpmc_blocking_queue
+class mpmc_blocking_queue final : public async_queue<T>
 {
 public:
     using item_type = T;
-    explicit mpmc_blocking_queue(size_t max_items)
-        : q_(max_items)
+    explicit mpmc_blocking_queue(size_t max_items, wait_policy policy = wait_policy::blocking())
+        : wait_policy_(policy)
+        , q_(max_items)
     {}
 
 /*
@@ -72,9 +81,8 @@ public:
 *
 */
 
-#ifndef __MINGW32__
     // try to enqueue and block if no room left
-    void enqueue(T &&item)
+    void enqueue(T &&item) override
     {
         // 1. 没有拿到锁
         //      等待锁释放
@@ -86,99 +94,212 @@ public:
         //    (2) 唤醒
         //        线程正在执行其他任务 不起作用
         //        等待线程 尝试重新获得锁 执行接下来的任务
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        for (unsigned int round = 0; q_.full(); round++)
         {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
+            if (wait_policy_.spins(round))
+            {
+                lock.unlock();
+                wait_policy_.backoff(round);
+                lock.lock();
+                continue;
+            }
+            producers_waiting_++;
             pop_cv_.wait(lock, [this] { return !this->q_.full(); });
-            q_.push_back(std::move(item));
+            producers_waiting_--;
         }
+        q_.push_back(std::move(item));
+        enqueued_counter_++;
+        full_hint_.store(q_.full(), std::memory_order_relaxed);
 
         // condition_variable 容许 wait 、 wait_for 、 wait_until 、 notify_one 及 notify_all 成员函数的同时调用。
         // 通知准备好的数据 不需要为通知上锁
-        push_cv_.notify_one();
+        if (consumers_waiting_ > 0)
+        {
+            notify_(lock, push_cv_, false);
+        }
     }
 
     // enqueue immediately. overrun oldest message in the queue if no room left.
-    void enqueue_nowait(T &&item)
+    // Return number of overrun messages (0 or 1)
+    size_t enqueue_nowait(T &&item) override
     {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        size_t overrun = q_.full() ? 1 : 0;
+        q_.push_back(std::move(item));
+        enqueued_counter_++;
+        full_hint_.store(q_.full(), std::memory_order_relaxed);
+        if (consumers_waiting_ > 0)
         {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            q_.push_back(std::move(item));
+            notify_(lock, push_cv_, false);
         }
-        push_cv_.notify_one();
+        return overrun;
     }
 
-    // try to dequeue item. if no item found. wait upto timeout and try again
-    // Return true, if succeeded dequeue item, false otherwise
-    bool dequeue_for(T &popped_item, std::chrono::milliseconds wait_duration)
+    // enqueue only if there is room left. Return false otherwise (item is not moved from)
+    // a full queue is detected without taking the mutex.
+    bool try_enqueue(T &&item) override
     {
+        if (full_hint_.load(std::memory_order_relaxed))
         {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            if (!push_cv_.wait_for(lock, wait_duration, [this] { return !this->q_.empty(); }))
-            {
-                return false;
-            }
-            popped_item = std::move(q_.front());
-            q_.pop_front();
+            return false;
+        }
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        if (q_.full())
+        {
+            return false;
+        }
+        q_.push_back(std::move(item));
+        enqueued_counter_++;
+        full_hint_.store(q_.full(), std::memory_order_relaxed);
+        if (consumers_waiting_ > 0)
+        {
+            notify_(lock, push_cv_, false);
         }
-        pop_cv_.notify_one();
         return true;
     }
 
-#else
-    // apparently mingw deadlocks if the mutex is released before cv.notify_one(),
-    // so release the mutex at the very end each function.
-
-    // try to enqueue and block if no room left
-    void enqueue(T &&item)
+    // try to dequeue item. if no item found. wait upto timeout and try again
+    // Return true, if succeeded dequeue item, false otherwise
+    bool dequeue_for(T &popped_item, std::chrono::milliseconds wait_duration) override
     {
         std::unique_lock<std::mutex> lock(queue_mutex_);
-        pop_cv_.wait(lock, [this] { return !this->q_.full(); });
-        q_.push_back(std::move(item));
-        push_cv_.notify_one();
+        if (!wait_not_empty_(lock, wait_duration))
+        {
+            return false;
+        }
+        popped_item = std::move(q_.front());
+        q_.pop_front();
+        full_hint_.store(false, std::memory_order_relaxed);
+        if (producers_waiting_ > 0)
+        {
+            notify_(lock, pop_cv_, false);
+        }
+        return true;
     }
 
-    // enqueue immediately. overrun oldest message in the queue if no room left.
-    void enqueue_nowait(T &&item)
+    // try to dequeue up to max_items. if no item found. wait upto timeout and try again
+    // Return number of dequeued items, 0 if timeout have passed
+    size_t dequeue_bulk(T *popped_items, size_t max_items, std::chrono::milliseconds wait_duration) override
     {
         std::unique_lock<std::mutex> lock(queue_mutex_);
-        q_.push_back(std::move(item));
-        push_cv_.notify_one();
+        if (!wait_not_empty_(lock, wait_duration))
+        {
+            return 0;
+        }
+        size_t n = 0;
+        for (; n < max_items && !q_.empty(); n++)
+        {
+            popped_items[n] = std::move(q_.front());
+            q_.pop_front();
+            full_hint_.store(false, std::memory_order_relaxed);
+        }
+        if (producers_waiting_ > 0)
+        {
+            notify_(lock, pop_cv_, true);
+        }
+        return n;
     }
 
-    // try to dequeue item. if no item found. wait upto timeout and try again
-    // Return true, if succeeded dequeue item, false otherwise
-    bool dequeue_for(T &popped_item, std::chrono::milliseconds wait_duration)
+    // poll until the items enqueued before the call left the queue (or deadline)
+    bool wait_dequeued(std::chrono::steady_clock::time_point deadline) override
     {
         std::unique_lock<std::mutex> lock(queue_mutex_);
-        if (!push_cv_.wait_for(lock, wait_duration, [this] { return !this->q_.empty(); }))
+        auto target = enqueued_counter_;
+        while (enqueued_counter_ - q_.size() < target)
         {
-            return false;
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                return false;
+            }
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            lock.lock();
         }
-        popped_item = std::move(q_.front());
-        q_.pop_front();
-        pop_cv_.notify_one();
         return true;
     }
 
-#endif
-
-    size_t overrun_counter()
+    size_t overrun_counter() override
     {
         std::unique_lock<std::mutex> lock(queue_mutex_);
         return q_.overrun_counter();
     }
 
-    size_t size()
+    size_t size() override
     {
         std::unique_lock<std::mutex> lock(queue_mutex_);
         return q_.size();
     }
 
+    // walks the queue as is, without the mutex (the size is re-read every item)
+    void for_each_unsafe(void (*fun)(const T &item, void *ctx), void *ctx) override
+    {
+        for (size_t i = 0; i < q_.size(); i++)
+        {
+            fun(q_.at(i), ctx);
+        }
+    }
+
 private:
+    wait_policy wait_policy_;
     std::mutex queue_mutex_;
     std::condition_variable push_cv_;
     std::condition_variable pop_cv_;
     spdlog::details::circular_q<T> q_;
+    size_t enqueued_counter_ = 0; // total number of items ever enqueued
+    size_t producers_waiting_ = 0; // waiting on pop_cv_
+    size_t consumers_waiting_ = 0; // waiting on push_cv_
+    std::atomic<bool> full_hint_{false}; // q_.full() as of the last push/pop. read without the mutex
+
+    // wait (by the wait policy) until the queue is not empty or timeout have passed
+    bool wait_not_empty_(std::unique_lock<std::mutex> &lock, std::chrono::milliseconds wait_duration)
+    {
+        if (!q_.empty())
+        {
+            return true;
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + wait_duration;
+        for (unsigned int round = 0; q_.empty(); round++)
+        {
+            if (wait_policy_.spins(round))
+            {
+                if (wait_policy::timed_out(round, deadline))
+                {
+                    return false;
+                }
+                lock.unlock();
+                wait_policy_.backoff(round);
+                lock.lock();
+                continue;
+            }
+            consumers_waiting_++;
+            bool signaled = push_cv_.wait_until(lock, deadline, [this] { return !this->q_.empty(); });
+            consumers_waiting_--;
+            return signaled;
+        }
+        return true;
+    }
+
+    void notify_(std::unique_lock<std::mutex> &lock, std::condition_variable &cv, bool all)
+    {
+#ifndef __MINGW32__
+        // 通知不需要持有锁 先释放 被唤醒的线程不必再等锁
+        lock.unlock();
+#else
+        // apparently mingw deadlocks if the mutex is released before cv.notify_one(),
+        // so notify with the mutex held.
+        (void)lock;
+#endif
+        if (all)
+        {
+            cv.notify_all();
+        }
+        else
+        {
+            cv.notify_one();
+        }
+    }
 };
 } // namespace details
 } // namespace spdlog
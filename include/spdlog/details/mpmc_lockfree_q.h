@@ -0,0 +1,314 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// multi producer-multi consumer lock free bounded queue.
+// Ring of slots, each guarded by a sequence number (Dmitry Vyukov's design):
+// producers and consumers only touch the queue indices and the slot they own,
+// so neither side takes a lock while the queue is busy.
+//
+// enqueue(..) - will wait (by the wait policy) until room found to put the new message.
+// enqueue_nowait(..) - will overrun the oldest message in the queue if no room left.
+// try_enqueue(..) - will return immediately with false if no room left.
+// dequeue_for(..) - will wait (by the wait policy) until the queue is not empty
+// or timeout have passed. adaptive by default: spin, then yield and only then park.
+//
+// Parking uses a mutex/condition variable pair, but the other side only touches
+// it when it sees a parked waiter, so the condition variables are never
+// notified while the consumer is awake.
+
+#include <spdlog/details/async_queue.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace spdlog {
+namespace details {
+
+template<typename T>
+class mpmc_lockfree_queue final : public async_queue<T>
+{
+public:
+    using item_type = T;
+    explicit mpmc_lockfree_queue(size_t max_items, wait_policy policy = wait_policy::adaptive())
+        : max_items_(max_items > 0 ? max_items : 1)
+        , wait_policy_(policy)
+        , cells_(new cell[max_items_])
+    {
+        for (size_t i = 0; i < max_items_; i++)
+        {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    mpmc_lockfree_queue(const mpmc_lockfree_queue &) = delete;
+    mpmc_lockfree_queue &operator=(const mpmc_lockfree_queue &) = delete;
+
+    // try to enqueue and block if no room left
+    void enqueue(T &&item) override
+    {
+        for (unsigned int round = 0; !try_push_(item); round++)
+        {
+            if (wait_policy_.spins(round))
+            {
+                wait_policy_.backoff(round);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            park_(producers_parked_);
+            pop_cv_.wait_for(lock, std::chrono::milliseconds(100), [this] { return !this->full_(); });
+            producers_parked_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        wake_(consumers_parked_, push_cv_);
+    }
+
+    // enqueue immediately. overrun oldest message in the queue if no room left.
+    // Return number of overrun messages
+    size_t enqueue_nowait(T &&item) override
+    {
+        size_t overrun = 0;
+        while (!try_push_(item))
+        {
+            T overrun_item;
+            if (try_pop_(overrun_item))
+            {
+                overrun_counter_.fetch_add(1, std::memory_order_relaxed);
+                overrun++;
+            }
+        }
+        wake_(consumers_parked_, push_cv_);
+        return overrun;
+    }
+
+    // enqueue only if there is room left. Return false otherwise (item is not moved from)
+    bool try_enqueue(T &&item) override
+    {
+        if (!try_push_(item))
+        {
+            return false;
+        }
+        wake_(consumers_parked_, push_cv_);
+        return true;
+    }
+
+    // try to dequeue item. if no item found. wait (by the wait policy) upto
+    // timeout and try again.
+    // Return true, if succeeded dequeue item, false otherwise
+    bool dequeue_for(T &popped_item, std::chrono::milliseconds wait_duration) override
+    {
+        if (!try_pop_(popped_item) && !wait_pop_(popped_item, wait_duration))
+        {
+            return false;
+        }
+        wake_(producers_parked_, pop_cv_);
+        return true;
+    }
+
+    // try to dequeue up to max_items. waits like dequeue_for(..) for the first one.
+    // Return number of dequeued items, 0 if timeout have passed
+    size_t dequeue_bulk(T *popped_items, size_t max_items, std::chrono::milliseconds wait_duration) override
+    {
+        if (max_items == 0 || !dequeue_for(popped_items[0], wait_duration))
+        {
+            return 0;
+        }
+        size_t n = 1;
+        while (n < max_items && try_pop_(popped_items[n]))
+        {
+            n++;
+        }
+        if (n > 1)
+        {
+            wake_(producers_parked_, pop_cv_);
+        }
+        return n;
+    }
+
+    // poll until the items enqueued before the call left the queue (or deadline)
+    bool wait_dequeued(std::chrono::steady_clock::time_point deadline) override
+    {
+        auto target = enqueue_pos_.load(std::memory_order_acquire);
+        while (dequeue_pos_.load(std::memory_order_acquire) < target)
+        {
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    size_t overrun_counter() override
+    {
+        return overrun_counter_.load(std::memory_order_relaxed);
+    }
+
+    // Return number of elements stored (approximate while producers/consumers are active)
+    size_t size() override
+    {
+        auto head = dequeue_pos_.load(std::memory_order_relaxed);
+        auto tail = enqueue_pos_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    // visit the published items only
+    void for_each_unsafe(void (*fun)(const T &item, void *ctx), void *ctx) override
+    {
+        auto head = dequeue_pos_.load(std::memory_order_acquire);
+        auto tail = enqueue_pos_.load(std::memory_order_acquire);
+        for (auto pos = head; pos < tail && pos - head < max_items_; pos++)
+        {
+            cell &c = cells_[pos % max_items_];
+            if (c.sequence.load(std::memory_order_acquire) == pos + 1)
+            {
+                fun(c.data, ctx);
+            }
+        }
+    }
+
+private:
+    struct cell
+    {
+        std::atomic<size_t> sequence{0};
+        T data;
+    };
+
+    // keep the producer and consumer indices on separate cache lines
+    static const size_t cacheline_size = 64;
+
+    size_t max_items_;
+    wait_policy wait_policy_;
+    std::unique_ptr<cell[]> cells_;
+    char pad0_[cacheline_size];
+    std::atomic<size_t> enqueue_pos_{0};
+    char pad1_[cacheline_size - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> dequeue_pos_{0};
+    char pad2_[cacheline_size - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> overrun_counter_{0};
+    std::atomic<size_t> producers_parked_{0};
+    std::atomic<size_t> consumers_parked_{0};
+    std::mutex mutex_;
+    std::condition_variable push_cv_;
+    std::condition_variable pop_cv_;
+
+    bool try_push_(T &item)
+    {
+        auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            cell &c = cells_[pos % max_items_];
+            auto seq = c.sequence.load(std::memory_order_acquire);
+            if (seq == pos)
+            {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    c.data = std::move(item);
+                    c.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (seq < pos)
+            {
+                return false; // full - the slot was not consumed yet
+            }
+            else
+            {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_pop_(T &popped_item)
+    {
+        auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            cell &c = cells_[pos % max_items_];
+            auto seq = c.sequence.load(std::memory_order_acquire);
+            if (seq == pos + 1)
+            {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    popped_item = std::move(c.data);
+                    c.sequence.store(pos + max_items_, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (seq < pos + 1)
+            {
+                return false; // empty - the slot was not published yet
+            }
+            else
+            {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool empty_() const
+    {
+        auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+        return cells_[pos % max_items_].sequence.load(std::memory_order_acquire) != pos + 1;
+    }
+
+    bool full_() const
+    {
+        auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+        return cells_[pos % max_items_].sequence.load(std::memory_order_acquire) != pos;
+    }
+
+    // announce a parked waiter (called with the mutex held).
+    // the fence pairs with the one in wake_(): either the waiter sees the new
+    // state in its wait predicate, or the other side sees the waiter and notifies.
+    static void park_(std::atomic<size_t> &parked)
+    {
+        parked.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    void wake_(std::atomic<size_t> &parked, std::condition_variable &cv)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked.load(std::memory_order_relaxed) > 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv.notify_all();
+        }
+    }
+
+    // wait until an item was popped or timeout have passed
+    bool wait_pop_(T &popped_item, std::chrono::milliseconds wait_duration)
+    {
+        auto deadline = std::chrono::steady_clock::now() + wait_duration;
+        for (unsigned int round = 0; !try_pop_(popped_item); round++)
+        {
+            if (wait_policy_.spins(round))
+            {
+                if (wait_policy::timed_out(round, deadline))
+                {
+                    return false;
+                }
+                wait_policy_.backoff(round);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            park_(consumers_parked_);
+            bool signaled = push_cv_.wait_until(lock, deadline, [this] { return !this->empty_(); });
+            consumers_parked_.fetch_sub(1, std::memory_order_relaxed);
+            if (!signaled)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace details
+} // namespace spdlog
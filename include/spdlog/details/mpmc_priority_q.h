@@ -0,0 +1,345 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// multi producer-multi consumer blocking queue with priority lanes.
+// Each item is put to the lane returned by lane_fn (a circular queue of its
+// own capacity). The consumers take the items of the lower numbered lanes
+// first, so items of a busy lane never delay the items of a higher priority one.
+//
+// Lane 0 is the control lane. Its items are taken before all the others too,
+// but only after the items enqueued before them to the other lanes (e.g. a
+// flush is never handled before the messages logged ahead of it).
+//
+// enqueue(..) - will block until room found in the item's lane.
+// enqueue_nowait(..) - will overrun the oldest item of the lane if no room left
+// (the control lane drops the new item instead - control items are not overrun.
+// such drops are counted by control_dropped_counter(), not by overrun_counter()).
+// try_enqueue(..) - will return immediately with false if no room left in the lane.
+// dequeue_for(..) - will block until the queue is not empty or timeout have passed.
+
+#include <spdlog/details/async_queue.h>
+#include <spdlog/details/circular_q.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace spdlog {
+namespace details {
+
+template<typename T>
+class mpmc_priority_queue final : public async_queue<T>
+{
+public:
+    using item_type = T;
+    using lane_fn = size_t (*)(const T &item);
+
+    // lanes_max_items - capacity of each lane (lane 0 is the control lane)
+    mpmc_priority_queue(const std::vector<size_t> &lanes_max_items, lane_fn lane_of, wait_policy policy = wait_policy::blocking())
+        : lane_of_(lane_of)
+        , wait_policy_(policy)
+        , full_hints_(new std::atomic<bool>[lanes_max_items.size()])
+    {
+        lanes_.reserve(lanes_max_items.size());
+        for (size_t i = 0; i < lanes_max_items.size(); i++)
+        {
+            lanes_.emplace_back(lanes_max_items[i]);
+            full_hints_[i].store(false, std::memory_order_relaxed);
+        }
+    }
+
+    mpmc_priority_queue(const mpmc_priority_queue &) = delete;
+    mpmc_priority_queue &operator=(const mpmc_priority_queue &) = delete;
+
+    // try to enqueue and block if no room left in the item's lane
+    void enqueue(T &&item) override
+    {
+        size_t lane = lane_index_(item);
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        for (unsigned int round = 0; lanes_[lane].items.full(); round++)
+        {
+            if (wait_policy_.spins(round))
+            {
+                lock.unlock();
+                wait_policy_.backoff(round);
+                lock.lock();
+                continue;
+            }
+            producers_waiting_++;
+            pop_cv_.wait(lock, [this, lane] { return !this->lanes_[lane].items.full(); });
+            producers_waiting_--;
+        }
+        push_(lane, std::move(item));
+        if (consumers_waiting_ > 0)
+        {
+            notify_(lock, push_cv_, false);
+        }
+    }
+
+    // enqueue immediately. overrun oldest item of the lane if no room left.
+    // Return number of overrun (or dropped) items
+    size_t enqueue_nowait(T &&item) override
+    {
+        size_t lane = lane_index_(item);
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        size_t overrun = 0;
+        if (lanes_[lane].items.full())
+        {
+            overrun = 1;
+            if (lane == 0)
+            {
+                control_dropped_++;
+                return overrun;
+            }
+            overrun_counter_++;
+            pop_front_(lane);
+        }
+        push_(lane, std::move(item));
+        if (consumers_waiting_ > 0)
+        {
+            notify_(lock, push_cv_, false);
+        }
+        return overrun;
+    }
+
+    // enqueue only if there is room left in the item's lane. Return false otherwise (item is not moved from).
+    // a full lane is detected without taking the mutex.
+    bool try_enqueue(T &&item) override
+    {
+        size_t lane = lane_index_(item);
+        if (full_hints_[lane].load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        if (lanes_[lane].items.full())
+        {
+            return false;
+        }
+        push_(lane, std::move(item));
+        if (consumers_waiting_ > 0)
+        {
+            notify_(lock, push_cv_, false);
+        }
+        return true;
+    }
+
+    // try to dequeue item. if no item found. wait upto timeout and try again
+    // Return true, if succeeded dequeue item, false otherwise
+    bool dequeue_for(T &popped_item, std::chrono::milliseconds wait_duration) override
+    {
+        return dequeue_bulk(&popped_item, 1, wait_duration) == 1;
+    }
+
+    // try to dequeue up to max_items, by the lanes priority. if no item found. wait upto timeout and try again
+    // Return number of dequeued items, 0 if timeout have passed
+    size_t dequeue_bulk(T *popped_items, size_t max_items, std::chrono::milliseconds wait_duration) override
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        if (max_items == 0 || !wait_not_empty_(lock, wait_duration))
+        {
+            return 0;
+        }
+        size_t n = 0;
+        for (; n < max_items && size_ > 0; n++)
+        {
+            pop_(popped_items[n]);
+        }
+        if (producers_waiting_ > 0)
+        {
+            notify_(lock, pop_cv_, true);
+        }
+        return n;
+    }
+
+    // poll until the items enqueued before the call left the queue (or deadline)
+    bool wait_dequeued(std::chrono::steady_clock::time_point deadline) override
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        auto target = next_seq_;
+        while (next_seq_ - size_ < target)
+        {
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                return false;
+            }
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            lock.lock();
+        }
+        return true;
+    }
+
+    size_t overrun_counter() override
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        return overrun_counter_;
+    }
+
+    // control items dropped by enqueue_nowait(..) because the control lane was full
+    size_t control_dropped_counter()
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        return control_dropped_;
+    }
+
+    size_t size() override
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        return size_;
+    }
+
+    // walks the lanes as is, without the mutex (the size is re-read every item)
+    void for_each_unsafe(void (*fun)(const T &item, void *ctx), void *ctx) override
+    {
+        for (auto &l : lanes_)
+        {
+            for (size_t i = 0; i < l.items.size(); i++)
+            {
+                fun(l.items.at(i), ctx);
+            }
+        }
+    }
+
+private:
+    // the items of a lane, and their enqueue order
+    struct lane_queue
+    {
+        explicit lane_queue(size_t max_items)
+            : items(max_items)
+            , seqs(max_items)
+        {}
+
+        circular_q<T> items;
+        circular_q<size_t> seqs;
+    };
+
+    lane_fn lane_of_;
+    wait_policy wait_policy_;
+    std::mutex queue_mutex_;
+    std::condition_variable push_cv_;
+    std::condition_variable pop_cv_;
+    std::vector<lane_queue> lanes_;
+    std::unique_ptr<std::atomic<bool>[]> full_hints_; // lanes_[i].items.full() as of the last push/pop. read without the mutex
+    size_t size_ = 0;              // items in all the lanes
+    size_t next_seq_ = 0;          // total number of items ever enqueued
+    size_t overrun_counter_ = 0;
+    size_t control_dropped_ = 0;
+    size_t producers_waiting_ = 0; // waiting on pop_cv_
+    size_t consumers_waiting_ = 0; // waiting on push_cv_
+
+    size_t lane_index_(const T &item) const
+    {
+        size_t lane = lane_of_(item);
+        return lane < lanes_.size() ? lane : lanes_.size() - 1;
+    }
+
+    void push_(size_t lane_index, T &&item)
+    {
+        auto &l = lanes_[lane_index];
+        l.items.push_back(std::move(item));
+        l.seqs.push_back(next_seq_++);
+        size_++;
+        full_hints_[lane_index].store(l.items.full(), std::memory_order_relaxed);
+    }
+
+    // pop the front of the control lane if all the items enqueued before it are gone,
+    // otherwise the front of the first non empty lane. called while not empty.
+    void pop_(T &popped_item)
+    {
+        size_t lane = first_data_lane_();
+        if (!lanes_[0].seqs.empty())
+        {
+            // the control item waits only for the items enqueued before it
+            auto control_seq = lanes_[0].seqs.front();
+            lane = 0;
+            for (size_t i = 1; i < lanes_.size(); i++)
+            {
+                if (!lanes_[i].seqs.empty() && lanes_[i].seqs.front() < control_seq)
+                {
+                    lane = i;
+                    break;
+                }
+            }
+        }
+
+        popped_item = std::move(lanes_[lane].items.front());
+        pop_front_(lane);
+    }
+
+    void pop_front_(size_t lane_index)
+    {
+        lanes_[lane_index].items.pop_front();
+        lanes_[lane_index].seqs.pop_front();
+        size_--;
+        full_hints_[lane_index].store(false, std::memory_order_relaxed);
+    }
+
+    size_t first_data_lane_() const
+    {
+        for (size_t i = 1; i < lanes_.size(); i++)
+        {
+            if (!lanes_[i].seqs.empty())
+            {
+                return i;
+            }
+        }
+        return 0;
+    }
+
+    // wait (by the wait policy) until the queue is not empty or timeout have passed
+    bool wait_not_empty_(std::unique_lock<std::mutex> &lock, std::chrono::milliseconds wait_duration)
+    {
+        if (size_ > 0)
+        {
+            return true;
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + wait_duration;
+        for (unsigned int round = 0; size_ == 0; round++)
+        {
+            if (wait_policy_.spins(round))
+            {
+                if (wait_policy::timed_out(round, deadline))
+                {
+                    return false;
+                }
+                lock.unlock();
+                wait_policy_.backoff(round);
+                lock.lock();
+                continue;
+            }
+            consumers_waiting_++;
+            bool signaled = push_cv_.wait_until(lock, deadline, [this] { return this->size_ > 0; });
+            consumers_waiting_--;
+            return signaled;
+        }
+        return true;
+    }
+
+    void notify_(std::unique_lock<std::mutex> &lock, std::condition_variable &cv, bool all)
+    {
+#ifndef __MINGW32__
+        lock.unlock();
+#else
+        // apparently mingw deadlocks if the mutex is released before cv.notify_one(),
+        // so notify with the mutex held.
+        (void)lock;
+#endif
+        if (all)
+        {
+            cv.notify_all();
+        }
+        else
+        {
+            cv.notify_one();
+        }
+    }
+};
+} // namespace details
+} // namespace spdlog
@@ -43,6 +43,7 @@
 #include <unistd.h>
 
 #ifdef __linux__
+#include <sched.h>       // for sched_setaffinity
 #include <sys/syscall.h> //Use gettid() syscall under linux to get thread id
 
 #elif defined(_AIX)
@@ -365,6 +366,29 @@ SPDLOG_INLINE void sleep_for_millis(int milliseconds) SPDLOG_NOEXCEPT
 #endif
 }
 
+SPDLOG_INLINE bool set_thread_affinity(size_t cpu_index) SPDLOG_NOEXCEPT
+{
+#if defined(_WIN32)
+    if (cpu_index >= sizeof(DWORD_PTR) * 8)
+    {
+        return false;
+    }
+    return ::SetThreadAffinityMask(::GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu_index) != 0;
+#elif defined(__linux__)
+    if (cpu_index >= CPU_SETSIZE)
+    {
+        return false;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu_index, &cpu_set);
+    return ::sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0;
+#else
+    (void)cpu_index;
+    return false;
+#endif
+}
+
 // wchar support for windows file names (SPDLOG_WCHAR_FILENAMES must be defined)
 #if defined(_WIN32) && defined(SPDLOG_WCHAR_FILENAMES)
 SPDLOG_INLINE std::string filename_to_str(const filename_t &filename)
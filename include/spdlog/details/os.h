@@ -76,6 +76,10 @@ SPDLOG_API size_t thread_id() SPDLOG_NOEXCEPT;
 // See https://github.com/gabime/spdlog/issues/609
 SPDLOG_API void sleep_for_millis(int milliseconds) SPDLOG_NOEXCEPT;
 
+// Pin the calling thread to the given cpu.
+// Return false if failed or not supported on this platform
+SPDLOG_API bool set_thread_affinity(size_t cpu_index) SPDLOG_NOEXCEPT;
+
 SPDLOG_API std::string filename_to_str(const filename_t &filename);
 
 SPDLOG_API int pid() SPDLOG_NOEXCEPT;
@@ -0,0 +1,150 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Per call site state of the sampled and rate limited log statements
+// (see the SPDLOG_<LEVEL>_EVERY_N and similar macros in spdlog.h).
+// Each limiter decides with a few atomic operations, before the message is
+// formatted (or its arguments evaluated). pass() reports how many messages were
+// suppressed since the previous one that passed.
+
+#include <spdlog/common.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+namespace spdlog {
+namespace details {
+
+// pass the 1st, (n+1)th, (2n+1)th.. message
+class every_n_limiter
+{
+public:
+    SPDLOG_CONSTEXPR explicit every_n_limiter(size_t n)
+        : n_(n > 0 ? n : 1)
+        , count_(0)
+    {}
+
+    bool pass(size_t &suppressed)
+    {
+        auto count = count_.fetch_add(1, std::memory_order_relaxed);
+        if (count % n_ != 0)
+        {
+            return false;
+        }
+        suppressed = count > 0 ? n_ - 1 : 0;
+        return true;
+    }
+
+private:
+    size_t n_;
+    std::atomic<size_t> count_;
+};
+
+// pass the first n messages only
+class first_n_limiter
+{
+public:
+    SPDLOG_CONSTEXPR explicit first_n_limiter(size_t n)
+        : n_(n)
+        , count_(0)
+    {}
+
+    bool pass(size_t &suppressed)
+    {
+        // once done, only a load - no writes to the shared cache line
+        if (count_.load(std::memory_order_relaxed) >= n_ || count_.fetch_add(1, std::memory_order_relaxed) >= n_)
+        {
+            return false;
+        }
+        suppressed = 0;
+        return true;
+    }
+
+private:
+    size_t n_;
+    std::atomic<size_t> count_;
+};
+
+using limiter_clock = std::chrono::steady_clock;
+
+inline std::int64_t limiter_now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(limiter_clock::now().time_since_epoch()).count();
+}
+
+// pass at most one message per interval
+class every_ms_limiter
+{
+public:
+    SPDLOG_CONSTEXPR explicit every_ms_limiter(std::int64_t interval_ms)
+        : interval_ns_(interval_ms * 1000000)
+        , next_ns_((std::numeric_limits<std::int64_t>::min)())
+        , suppressed_(0)
+    {}
+
+    bool pass(size_t &suppressed)
+    {
+        auto now = limiter_now_ns();
+        auto next = next_ns_.load(std::memory_order_relaxed);
+        if (now < next || !next_ns_.compare_exchange_strong(next, now + interval_ns_, std::memory_order_relaxed))
+        {
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    std::int64_t interval_ns_;
+    std::atomic<std::int64_t> next_ns_;
+    std::atomic<size_t> suppressed_;
+};
+
+// token bucket of burst tokens, refilled at per_second tokens per second.
+// kept as the time the bucket would be full again (GCRA), so it is a single atomic.
+class token_bucket_limiter
+{
+public:
+    SPDLOG_CONSTEXPR token_bucket_limiter(double per_second, size_t burst)
+        : interval_ns_(per_second > 0 ? static_cast<std::int64_t>(1e9 / per_second) : (std::numeric_limits<std::int64_t>::max)() / 4)
+        , tolerance_ns_(per_second > 0 && burst > 1 ? static_cast<std::int64_t>(1e9 / per_second * static_cast<double>(burst - 1)) : 0)
+        , tat_ns_((std::numeric_limits<std::int64_t>::min)())
+        , suppressed_(0)
+    {}
+
+    bool pass(size_t &suppressed)
+    {
+        auto now = limiter_now_ns();
+        auto tat = tat_ns_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            // theoretical arrival time of this message
+            auto arrival = tat > now ? tat : now;
+            if (arrival - now > tolerance_ns_)
+            {
+                suppressed_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (tat_ns_.compare_exchange_weak(tat, arrival + interval_ns_, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    std::int64_t interval_ns_;
+    std::int64_t tolerance_ns_;
+    std::atomic<std::int64_t> tat_ns_;
+    std::atomic<size_t> suppressed_;
+};
+
+} // namespace details
+} // namespace spdlog
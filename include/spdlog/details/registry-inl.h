@@ -8,6 +8,7 @@
 #endif
 
 #include <spdlog/common.h>
+#include <spdlog/details/callsite.h>
 #include <spdlog/details/periodic_worker.h>
 #include <spdlog/logger.h>
 #include <spdlog/pattern_formatter.h>
@@ -122,6 +123,7 @@ SPDLOG_INLINE void registry::set_default_logger(std::shared_ptr<logger> new_defa
         loggers_[new_default_logger->name()] = new_default_logger;
     }
     default_logger_ = std::move(new_default_logger);
+    callsite::invalidate_all();
 }
 
 SPDLOG_INLINE void registry::set_tp(std::shared_ptr<thread_pool> tp)
@@ -230,6 +232,7 @@ SPDLOG_INLINE void registry::drop(const std::string &logger_name)
     if (default_logger_ && default_logger_->name() == logger_name)
     {
         default_logger_.reset();
+        callsite::invalidate_all();
     }
 }
 
@@ -238,6 +241,7 @@ SPDLOG_INLINE void registry::drop_all()
     std::lock_guard<std::mutex> lock(logger_map_mutex_);
     loggers_.clear();
     default_logger_.reset();
+    callsite::invalidate_all();
 }
 
 // clean all resources and threads started by the registry
@@ -0,0 +1,68 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef SPDLOG_HEADER_ONLY
+#include <spdlog/details/scratch_buffer.h>
+#endif
+
+namespace spdlog {
+namespace details {
+
+SPDLOG_INLINE scratch_buffer::scratch_buffer()
+    : tls_(thread_buffers_())
+    , buf_(&local_)
+{
+    if (tls_ != nullptr && tls_->depth < max_depth)
+    {
+        buf_ = &tls_->bufs[tls_->depth++];
+        buf_->clear();
+    }
+}
+
+SPDLOG_INLINE scratch_buffer::~scratch_buffer()
+{
+    if (buf_ == &local_)
+    {
+        return;
+    }
+    if (buf_->capacity() > SPDLOG_SCRATCH_BUFFER_MAX_SIZE)
+    {
+        *buf_ = memory_buf_t();
+    }
+    tls_->depth--;
+}
+
+SPDLOG_INLINE scratch_buffer::thread_buffers::~thread_buffers()
+{
+    // logging from later thread exit destructors falls back to local buffers
+    thread_buffers_destroyed_() = true;
+}
+
+SPDLOG_INLINE scratch_buffer::thread_buffers *scratch_buffer::thread_buffers_()
+{
+#ifndef SPDLOG_NO_TLS
+    if (thread_buffers_destroyed_())
+    {
+        return nullptr;
+    }
+    static thread_local thread_buffers buffers;
+    return &buffers;
+#else
+    return nullptr;
+#endif
+}
+
+SPDLOG_INLINE bool &scratch_buffer::thread_buffers_destroyed_()
+{
+#ifndef SPDLOG_NO_TLS
+    static thread_local bool destroyed = false;
+#else
+    static bool destroyed = false;
+#endif
+    return destroyed;
+}
+
+} // namespace details
+} // namespace spdlog
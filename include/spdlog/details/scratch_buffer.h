@@ -0,0 +1,64 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Thread local buffer to format a message into.
+// The buffers keep their capacity between log calls, so messages that don't fit
+// in the inline part of memory_buf_t don't allocate each time.
+// Nested use (a sink or a formatter that logs) takes the next buffer of the thread,
+// deeper than max_depth (or without thread local storage) a plain local buffer is used.
+// Buffers that grew beyond SPDLOG_SCRATCH_BUFFER_MAX_SIZE are released after use.
+//
+//   details::scratch_buffer formatted;
+//   formatter_->format(msg, formatted.get());
+
+#include <spdlog/common.h>
+
+#ifndef SPDLOG_SCRATCH_BUFFER_MAX_SIZE
+#define SPDLOG_SCRATCH_BUFFER_MAX_SIZE (64 * 1024)
+#endif
+
+namespace spdlog {
+namespace details {
+
+class SPDLOG_API scratch_buffer
+{
+public:
+    static const size_t max_depth = 6;
+
+    scratch_buffer();
+    ~scratch_buffer();
+
+    scratch_buffer(const scratch_buffer &) = delete;
+    scratch_buffer &operator=(const scratch_buffer &) = delete;
+
+    // empty on construction
+    memory_buf_t &get()
+    {
+        return *buf_;
+    }
+
+private:
+    struct thread_buffers
+    {
+        memory_buf_t bufs[max_depth];
+        size_t depth = 0;
+        ~thread_buffers();
+    };
+
+    // nullptr without thread local storage, or once the thread's buffers were destroyed
+    static thread_buffers *thread_buffers_();
+    static bool &thread_buffers_destroyed_();
+
+    thread_buffers *tls_;
+    memory_buf_t *buf_;
+    memory_buf_t local_;
+};
+
+} // namespace details
+} // namespace spdlog
+
+#ifdef SPDLOG_HEADER_ONLY
+#include "scratch_buffer-inl.h"
+#endif
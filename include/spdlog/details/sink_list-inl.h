@@ -0,0 +1,226 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#ifndef SPDLOG_HEADER_ONLY
+#include <spdlog/details/sink_list.h>
+#endif
+
+#include <algorithm>
+#include <thread>
+
+namespace spdlog {
+namespace details {
+
+SPDLOG_INLINE sink_list::sink_list()
+    : sink_list(sinks_t{})
+{}
+
+SPDLOG_INLINE sink_list::sink_list(sinks_t sinks)
+    : current_(new sinks_t(std::move(sinks)))
+{}
+
+SPDLOG_INLINE sink_list::sink_list(const sink_list &other)
+    : sink_list(other.copy())
+{}
+
+// the moved from list is empty (and has no snapshot)
+SPDLOG_INLINE sink_list::sink_list(sink_list &&other) SPDLOG_NOEXCEPT : current_(other.current_.exchange(nullptr)) {}
+
+SPDLOG_INLINE sink_list::~sink_list()
+{
+    delete current_.load();
+}
+
+SPDLOG_INLINE void sink_list::swap(sink_list &other) SPDLOG_NOEXCEPT
+{
+    auto *mine = current_.load();
+    current_.store(other.current_.exchange(mine));
+}
+
+SPDLOG_INLINE void sink_list::add(sink_ptr sink)
+{
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    auto *current = current_.load();
+    auto *next = current != nullptr ? new sinks_t(*current) : new sinks_t();
+    next->push_back(std::move(sink));
+    publish_(next);
+}
+
+SPDLOG_INLINE bool sink_list::remove(const sink_ptr &sink)
+{
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    auto *current = current_.load();
+    if (current == nullptr || std::find(current->begin(), current->end(), sink) == current->end())
+    {
+        return false;
+    }
+    auto *next = new sinks_t(*current);
+    next->erase(std::remove(next->begin(), next->end(), sink), next->end());
+    publish_(next);
+    return true;
+}
+
+SPDLOG_INLINE void sink_list::set(sinks_t sinks)
+{
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    publish_(new sinks_t(std::move(sinks)));
+}
+
+SPDLOG_INLINE sink_list::sinks_t sink_list::copy() const
+{
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    auto *current = current_.load();
+    return current != nullptr ? *current : sinks_t{};
+}
+
+SPDLOG_INLINE sink_list::editor sink_list::edit()
+{
+    return editor(*this);
+}
+
+SPDLOG_INLINE void sink_list::publish_(sinks_t *next)
+{
+    auto *prev = current_.exchange(next, std::memory_order_seq_cst);
+    // new readers see next. wait for the ones that marked prev.
+    for (auto *slot = sink_reader_slot::all().load(std::memory_order_acquire); slot != nullptr; slot = slot->next)
+    {
+        while (slot->snapshot.load(std::memory_order_seq_cst) == prev)
+        {
+            std::this_thread::yield();
+        }
+    }
+    delete prev;
+}
+
+#ifndef SPDLOG_NO_TLS
+// the slots of the calling thread, by nesting depth. given back when the thread exits.
+struct sink_list::thread_slots
+{
+    static const size_t max_depth = 8;
+    sink_reader_slot *slots[max_depth] = {};
+    size_t depth = 0;
+
+    ~thread_slots()
+    {
+        // readers in later thread exit destructors fall back to claim_slot_()
+        thread_slots_destroyed_() = true;
+        for (auto *&slot : slots)
+        {
+            if (slot != nullptr)
+            {
+                slot->in_use.store(false, std::memory_order_release);
+                slot = nullptr;
+            }
+        }
+    }
+};
+
+SPDLOG_INLINE sink_list::thread_slots *sink_list::this_thread_slots_()
+{
+    if (thread_slots_destroyed_())
+    {
+        return nullptr;
+    }
+    static thread_local thread_slots slots;
+    return &slots;
+}
+
+SPDLOG_INLINE bool &sink_list::thread_slots_destroyed_()
+{
+    static thread_local bool destroyed = false;
+    return destroyed;
+}
+#endif
+
+// deeper nested readers (and all of them without thread local storage) claim a slot each time
+SPDLOG_INLINE sink_reader_slot *sink_list::acquire_slot_()
+{
+#ifndef SPDLOG_NO_TLS
+    auto *mine = this_thread_slots_();
+    if (mine != nullptr)
+    {
+        auto depth = mine->depth++;
+        if (depth < thread_slots::max_depth)
+        {
+            if (mine->slots[depth] == nullptr)
+            {
+                mine->slots[depth] = claim_slot_();
+            }
+            return mine->slots[depth];
+        }
+    }
+#endif
+    return claim_slot_();
+}
+
+SPDLOG_INLINE void sink_list::release_slot_(sink_reader_slot *slot)
+{
+#ifndef SPDLOG_NO_TLS
+    auto *mine = this_thread_slots_();
+    if (mine != nullptr && --mine->depth < thread_slots::max_depth)
+    {
+        return;
+    }
+#endif
+    slot->in_use.store(false, std::memory_order_release);
+}
+
+SPDLOG_INLINE sink_reader_slot *sink_list::claim_slot_()
+{
+    auto &all = sink_reader_slot::all();
+    for (auto *slot = all.load(std::memory_order_acquire); slot != nullptr; slot = slot->next)
+    {
+        bool in_use = false;
+        if (!slot->in_use.load(std::memory_order_relaxed) &&
+            slot->in_use.compare_exchange_strong(in_use, true, std::memory_order_acquire))
+        {
+            return slot;
+        }
+    }
+    auto *slot = new sink_reader_slot();
+    slot->next = all.load(std::memory_order_relaxed);
+    while (!all.compare_exchange_weak(slot->next, slot, std::memory_order_release, std::memory_order_relaxed)) {}
+    return slot;
+}
+
+SPDLOG_INLINE std::atomic<sink_reader_slot *> &sink_reader_slot::all()
+{
+    static std::atomic<sink_reader_slot *> slots{nullptr};
+    return slots;
+}
+
+SPDLOG_INLINE sink_list::editor::editor(sink_list &list)
+    : list_(&list)
+    , lock_(list.write_mutex_)
+{
+    auto *current = list.current_.load();
+    if (current != nullptr)
+    {
+        sinks_ = *current;
+    }
+}
+
+SPDLOG_INLINE sink_list::editor::editor(editor &&other) SPDLOG_NOEXCEPT : list_(other.list_),
+                                                                          lock_(std::move(other.lock_)),
+                                                                          sinks_(std::move(other.sinks_))
+{
+    other.list_ = nullptr;
+}
+
+SPDLOG_INLINE sink_list::editor::~editor()
+{
+    if (list_ == nullptr)
+    {
+        return;
+    }
+    auto *current = list_->current_.load();
+    if (current == nullptr || *current != sinks_)
+    {
+        list_->publish_(new sinks_t(std::move(sinks_)));
+    }
+}
+
+} // namespace details
+} // namespace spdlog
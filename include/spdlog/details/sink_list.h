@@ -0,0 +1,213 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// RCU style list of sinks (the sinks of a logger).
+// The logging threads read an immutable snapshot of the list and take no lock.
+// add/remove/set copy the list, publish the copy and wait for the readers of
+// the previous snapshot to leave before destroying it (so a removed sink is
+// released once the messages being written to it are done).
+//
+// A reader marks the snapshot it reads in a slot of its own (a hazard pointer),
+// so the logging threads never write to a shared cache line. A thread keeps its
+// slots (one per nesting depth) and gives them back when it exits (readers in
+// later thread exit destructors claim a slot each time). A writer scans all the
+// slots for the previous snapshot.
+// The writers must not be called from a sink of the same list (they would wait
+// for themselves).
+
+#include <spdlog/common.h>
+
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace spdlog {
+namespace details {
+
+// the mark of a reader. never freed - given back to the list when released.
+struct SPDLOG_API sink_reader_slot
+{
+    std::atomic<const std::vector<sink_ptr> *> snapshot{nullptr};
+    std::atomic<bool> in_use{true};
+    sink_reader_slot *next = nullptr;
+
+    // all the slots ever allocated
+    static std::atomic<sink_reader_slot *> &all();
+};
+
+class SPDLOG_API sink_list
+{
+public:
+    using sinks_t = std::vector<sink_ptr>;
+
+    // a snapshot of the list, valid while the reader is alive
+    class reader
+    {
+    public:
+        explicit reader(const sink_list &list)
+            : slot_(acquire_slot_())
+        {
+            auto *sinks = list.current_.load(std::memory_order_acquire);
+            for (;;)
+            {
+                slot_->snapshot.store(sinks, std::memory_order_seq_cst);
+                auto *current = list.current_.load(std::memory_order_seq_cst);
+                if (current == sinks)
+                {
+                    break;
+                }
+                sinks = current;
+            }
+            sinks_ = sinks;
+        }
+
+        ~reader()
+        {
+            slot_->snapshot.store(nullptr, std::memory_order_release);
+            release_slot_(slot_);
+        }
+
+        reader(const reader &) = delete;
+        reader &operator=(const reader &) = delete;
+
+        const sink_ptr *begin() const
+        {
+            return sinks_ != nullptr ? sinks_->data() : nullptr;
+        }
+
+        const sink_ptr *end() const
+        {
+            return sinks_ != nullptr ? sinks_->data() + sinks_->size() : nullptr;
+        }
+
+        size_t size() const
+        {
+            return sinks_ != nullptr ? sinks_->size() : 0;
+        }
+
+    private:
+        sink_reader_slot *slot_;
+        const sinks_t *sinks_;
+    };
+
+    // a copy of the list to change in place. holds the writers' lock, and publishes
+    // the copy (if it was changed) when it goes away.
+    class SPDLOG_API editor
+    {
+    public:
+        explicit editor(sink_list &list);
+        editor(editor &&other) SPDLOG_NOEXCEPT;
+        ~editor();
+
+        editor(const editor &) = delete;
+        editor &operator=(const editor &) = delete;
+
+        sinks_t &operator*()
+        {
+            return sinks_;
+        }
+
+        sinks_t *operator->()
+        {
+            return &sinks_;
+        }
+
+        sinks_t::iterator begin()
+        {
+            return sinks_.begin();
+        }
+
+        sinks_t::iterator end()
+        {
+            return sinks_.end();
+        }
+
+        size_t size() const
+        {
+            return sinks_.size();
+        }
+
+        bool empty() const
+        {
+            return sinks_.empty();
+        }
+
+        sink_ptr &operator[](size_t index)
+        {
+            return sinks_[index];
+        }
+
+        void push_back(sink_ptr sink)
+        {
+            sinks_.push_back(std::move(sink));
+        }
+
+        sinks_t::iterator erase(sinks_t::iterator pos)
+        {
+            return sinks_.erase(pos);
+        }
+
+        void clear()
+        {
+            sinks_.clear();
+        }
+
+    private:
+        sink_list *list_;
+        std::unique_lock<std::mutex> lock_;
+        sinks_t sinks_;
+    };
+
+    sink_list();
+    explicit sink_list(sinks_t sinks);
+
+    template<typename It>
+    sink_list(It begin, It end)
+        : sink_list(sinks_t(begin, end))
+    {}
+
+    // copies the other's current snapshot
+    sink_list(const sink_list &other);
+    sink_list(sink_list &&other) SPDLOG_NOEXCEPT;
+    sink_list &operator=(const sink_list &) = delete;
+    ~sink_list();
+
+    // not thread safe
+    void swap(sink_list &other) SPDLOG_NOEXCEPT;
+
+    void add(sink_ptr sink);
+    // return false if the sink is not in the list
+    bool remove(const sink_ptr &sink);
+    void set(sinks_t sinks);
+    sinks_t copy() const;
+
+    editor edit();
+
+private:
+    mutable std::mutex write_mutex_;
+    std::atomic<sinks_t *> current_;
+
+    // publish next and destroy the previous snapshot once its readers left. called with write_mutex_ held.
+    void publish_(sinks_t *next);
+
+#ifndef SPDLOG_NO_TLS
+    struct thread_slots;
+    // nullptr once the thread's slots were destroyed
+    static thread_slots *this_thread_slots_();
+    static bool &thread_slots_destroyed_();
+#endif
+    static sink_reader_slot *acquire_slot_();
+    static void release_slot_(sink_reader_slot *slot);
+    // take a free slot from the list of all the slots, or add a new one
+    static sink_reader_slot *claim_slot_();
+};
+
+} // namespace details
+} // namespace spdlog
+
+#ifdef SPDLOG_HEADER_ONLY
+#include "sink_list-inl.h"
+#endif
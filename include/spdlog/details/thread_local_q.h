@@ -0,0 +1,555 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// per producer thread staging queue.
+// Each producer thread owns a single producer-single consumer ring (created on
+// its first enqueue and registered with the queue), so producers never share
+// a cache line with each other. The consumer side round-robins over all the
+// registered rings, or, if created as ordered, merges their fronts by the
+// items time (T is expected to have a "time" member, like log_msg).
+// Items for which timed_fn returns true (e.g. control messages) are merged by time
+// in the round-robin mode too, so they never overtake older items of other rings.
+//
+// enqueue(..) - will wait (by the wait policy) until room found in the thread's ring.
+// enqueue_nowait(..) - a producer cannot pop from its own ring, so if no room
+// left the new message is dropped and counted in the overrun counter.
+// try_enqueue(..) - will return immediately with false if no room left in the thread's ring.
+// dequeue_for(..) - will wait (by the wait policy) until some ring is not empty
+// or timeout have passed. adaptive by default: spin, then yield and only then park.
+//
+// The ring of a thread that exits is unregistered once the consumer drained it.
+
+#include <spdlog/common.h>
+#include <spdlog/details/async_queue.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace spdlog {
+namespace details {
+
+template<typename T>
+class thread_local_queue final : public async_queue<T>
+{
+public:
+    using item_type = T;
+    using timed_fn = bool (*)(const T &item);
+
+    thread_local_queue(
+        size_t max_items_per_thread, bool ordered, wait_policy policy = wait_policy::adaptive(), timed_fn timed = nullptr)
+        : max_items_(max_items_per_thread > 0 ? max_items_per_thread : 1)
+        , ordered_(ordered)
+        , timed_(timed)
+        , wait_policy_(policy)
+        , id_(next_queue_id_())
+    {
+#ifdef SPDLOG_NO_TLS
+        throw_spdlog_ex("thread_local_queue: per thread queues need thread local storage (SPDLOG_NO_TLS is defined)");
+#endif
+    }
+
+    thread_local_queue(const thread_local_queue &) = delete;
+    thread_local_queue &operator=(const thread_local_queue &) = delete;
+
+    ~thread_local_queue() override
+    {
+        // let the threads that still own a ring know it is no longer needed
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        for (auto &r : rings_)
+        {
+            r->orphaned.store(true, std::memory_order_relaxed);
+            withdraw_(r.get());
+        }
+    }
+
+    // try to enqueue and block if no room left in this thread's ring
+    void enqueue(T &&item) override
+    {
+        ring &r = this_thread_ring_();
+        for (unsigned int round = 0; !r.try_push(item); round++)
+        {
+            if (wait_policy_.spins(round))
+            {
+                wait_policy_.backoff(round);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(park_mutex_);
+            park_(producers_parked_);
+            pop_cv_.wait_for(lock, std::chrono::milliseconds(100), [&r] { return !r.full(); });
+            producers_parked_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        wake_(consumers_parked_, push_cv_);
+    }
+
+    // enqueue immediately. drop the new message if no room left in this thread's ring.
+    // Return number of dropped messages (0 or 1)
+    size_t enqueue_nowait(T &&item) override
+    {
+        if (!try_enqueue(std::move(item)))
+        {
+            overrun_counter_.fetch_add(1, std::memory_order_relaxed);
+            return 1;
+        }
+        return 0;
+    }
+
+    // enqueue only if there is room left in this thread's ring. Return false otherwise (item is not moved from)
+    bool try_enqueue(T &&item) override
+    {
+        if (!this_thread_ring_().try_push(item))
+        {
+            return false;
+        }
+        wake_(consumers_parked_, push_cv_);
+        return true;
+    }
+
+    // try to dequeue item from one of the rings. if no item found. spin, yield and
+    // then wait upto timeout and try again.
+    // Return true, if succeeded dequeue item, false otherwise
+    bool dequeue_for(T &popped_item, std::chrono::milliseconds wait_duration) override
+    {
+        return dequeue_bulk(&popped_item, 1, wait_duration) == 1;
+    }
+
+    // try to dequeue up to max_items. waits like dequeue_for(..) for the first one.
+    // Return number of dequeued items, 0 if timeout have passed
+    size_t dequeue_bulk(T *popped_items, size_t max_items, std::chrono::milliseconds wait_duration) override
+    {
+        size_t n = max_items > 0 ? wait_pop_(popped_items, max_items, wait_duration) : 0;
+        if (n > 0)
+        {
+            wake_(producers_parked_, pop_cv_);
+        }
+        return n;
+    }
+
+    // poll until the items enqueued before the call left their rings (or deadline)
+    bool wait_dequeued(std::chrono::steady_clock::time_point deadline) override
+    {
+        std::vector<std::pair<ring_ptr, size_t>> targets;
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex_);
+            for (auto &r : rings_)
+            {
+                targets.emplace_back(r, r->tail_.load(std::memory_order_acquire));
+            }
+        }
+        for (auto &target : targets)
+        {
+            while (target.first->head_.load(std::memory_order_acquire) < target.second)
+            {
+                if (std::chrono::steady_clock::now() >= deadline)
+                {
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        return true;
+    }
+
+    size_t overrun_counter() override
+    {
+        return overrun_counter_.load(std::memory_order_relaxed);
+    }
+
+    // Return number of elements stored in all the rings (approximate while producers are active)
+    size_t size() override
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        size_t total = 0;
+        for (auto &r : rings_)
+        {
+            total += r->size();
+        }
+        return total;
+    }
+
+    // walks the rings published in published_rings_, so no lock is taken.
+    // rings registered beyond published_max are skipped.
+    void for_each_unsafe(void (*fun)(const T &item, void *ctx), void *ctx) override
+    {
+        for (auto &published : published_rings_)
+        {
+            ring *r = published.load(std::memory_order_acquire);
+            if (r == nullptr)
+            {
+                continue;
+            }
+            auto head = r->head_.load(std::memory_order_acquire);
+            auto tail = r->tail_.load(std::memory_order_acquire);
+            for (auto pos = head; pos < tail && pos - head < r->capacity; pos++)
+            {
+                fun(r->slots[pos % r->capacity], ctx);
+            }
+        }
+    }
+
+private:
+    static const size_t cacheline_size = 64;
+
+    // single producer-single consumer ring. head_ and tail_ only grow.
+    struct ring
+    {
+        explicit ring(size_t max_items)
+            : capacity(max_items)
+            , slots(new T[max_items])
+        {}
+
+        bool try_push(T &item)
+        {
+            auto tail = tail_.load(std::memory_order_relaxed);
+            if (tail - cached_head_ >= capacity)
+            {
+                cached_head_ = head_.load(std::memory_order_acquire);
+                if (tail - cached_head_ >= capacity)
+                {
+                    return false;
+                }
+            }
+            slots[tail % capacity] = std::move(item);
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // return the front item or nullptr if the ring is empty. consumer side only.
+        T *front()
+        {
+            auto head = head_.load(std::memory_order_relaxed);
+            if (head == tail_.load(std::memory_order_acquire))
+            {
+                return nullptr;
+            }
+            return &slots[head % capacity];
+        }
+
+        void pop_front()
+        {
+            head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        bool empty() const
+        {
+            return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+        }
+
+        bool full() const
+        {
+            return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire) >= capacity;
+        }
+
+        size_t size() const
+        {
+            auto head = head_.load(std::memory_order_acquire);
+            auto tail = tail_.load(std::memory_order_acquire);
+            return tail > head ? tail - head : 0;
+        }
+
+        const size_t capacity;
+        std::unique_ptr<T[]> slots;
+        std::atomic<bool> closed{false};   // owner thread exited
+        std::atomic<bool> orphaned{false}; // queue was destroyed
+        char pad0_[cacheline_size];
+        std::atomic<size_t> head_{0};
+        char pad1_[cacheline_size - sizeof(std::atomic<size_t>)];
+        std::atomic<size_t> tail_{0};
+        size_t cached_head_{0}; // producer's last seen head_
+    };
+
+    using ring_ptr = std::shared_ptr<ring>;
+
+    // thread local handle of a producer ring. marks the ring as closed when its thread exits.
+    struct ring_handle
+    {
+        ring_handle(size_t id, ring_ptr r)
+            : queue_id(id)
+            , ring_ref(std::move(r))
+        {}
+        ring_handle(ring_handle &&) = default;
+        ring_handle &operator=(ring_handle &&) = default;
+        ~ring_handle()
+        {
+            if (ring_ref)
+            {
+                ring_ref->closed.store(true, std::memory_order_release);
+            }
+        }
+
+        size_t queue_id;
+        ring_ptr ring_ref;
+    };
+
+    const size_t max_items_;
+    const bool ordered_;
+    const timed_fn timed_;
+    const wait_policy wait_policy_;
+    const size_t id_;
+
+    // producer rings registered so far. guarded by registry_mutex_.
+    std::mutex registry_mutex_;
+    std::vector<ring_ptr> rings_;
+    std::atomic<size_t> registry_version_{0};
+
+    // raw pointers to the registered rings for for_each_unsafe(..). set and cleared
+    // with registry_mutex_ held, before a ring is dropped from rings_.
+    static const size_t published_max = 64;
+    std::atomic<ring *> published_rings_[published_max]{};
+
+    // consumer side copy of rings_. guarded by consumer_mutex_.
+    std::mutex consumer_mutex_;
+    std::vector<ring_ptr> consumer_rings_;
+    size_t consumer_version_ = 0;
+    size_t next_ring_ = 0;
+
+    std::atomic<size_t> overrun_counter_{0};
+    std::atomic<size_t> producers_parked_{0};
+    std::atomic<size_t> consumers_parked_{0};
+    std::mutex park_mutex_;
+    std::condition_variable push_cv_;
+    std::condition_variable pop_cv_;
+
+    static size_t next_queue_id_()
+    {
+        static std::atomic<size_t> last_id{0};
+        return ++last_id;
+    }
+
+    ring &this_thread_ring_()
+    {
+        static thread_local std::vector<ring_handle> handles;
+        for (auto &h : handles)
+        {
+            if (h.queue_id == id_)
+            {
+                return *h.ring_ref;
+            }
+        }
+
+        // first enqueue from this thread - forget rings of destroyed queues and register a new one.
+        for (auto it = handles.begin(); it != handles.end();)
+        {
+            it = it->ring_ref->orphaned.load(std::memory_order_relaxed) ? handles.erase(it) : std::next(it);
+        }
+        auto new_ring = std::make_shared<ring>(max_items_);
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex_);
+            rings_.push_back(new_ring);
+            publish_(new_ring.get());
+            registry_version_.fetch_add(1, std::memory_order_release);
+        }
+        handles.emplace_back(id_, new_ring);
+        return *new_ring;
+    }
+
+    // called with registry_mutex_ held
+    void publish_(ring *r)
+    {
+        for (auto &published : published_rings_)
+        {
+            if (published.load(std::memory_order_relaxed) == nullptr)
+            {
+                published.store(r, std::memory_order_release);
+                return;
+            }
+        }
+    }
+
+    void withdraw_(ring *r)
+    {
+        for (auto &published : published_rings_)
+        {
+            if (published.load(std::memory_order_relaxed) == r)
+            {
+                published.store(nullptr, std::memory_order_release);
+                return;
+            }
+        }
+    }
+
+    // refresh consumer_rings_ if rings were registered since last time.
+    // drop rings whose thread exited and were drained. called with consumer_mutex_ held.
+    void refresh_rings_()
+    {
+        bool drop_closed = false;
+        for (auto &r : consumer_rings_)
+        {
+            drop_closed = drop_closed || (r->closed.load(std::memory_order_acquire) && r->empty());
+        }
+
+        if (!drop_closed && registry_version_.load(std::memory_order_acquire) == consumer_version_)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        if (drop_closed)
+        {
+            for (auto it = rings_.begin(); it != rings_.end();)
+            {
+                if ((*it)->closed.load(std::memory_order_acquire) && (*it)->empty())
+                {
+                    withdraw_(it->get());
+                    it = rings_.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+            registry_version_.fetch_add(1, std::memory_order_release);
+        }
+        consumer_rings_ = rings_;
+        consumer_version_ = registry_version_.load(std::memory_order_acquire);
+    }
+
+    bool try_pop_(T &popped_item)
+    {
+        refresh_rings_();
+        auto n_rings = consumer_rings_.size();
+        if (n_rings == 0)
+        {
+            return false;
+        }
+
+        ring *selected = nullptr;
+        for (size_t i = 0; i < n_rings; i++)
+        {
+            size_t index = (next_ring_ + i) % n_rings;
+            ring *r = consumer_rings_[index].get();
+            T *front = r->front();
+            if (front == nullptr)
+            {
+                continue;
+            }
+            if (!ordered_)
+            {
+                selected = r;
+                next_ring_ = index + 1;
+                break;
+            }
+            if (selected == nullptr || front->time < selected->front()->time)
+            {
+                selected = r;
+            }
+        }
+
+        if (selected == nullptr)
+        {
+            return false;
+        }
+        if (!ordered_ && timed_ != nullptr && timed_(*selected->front()))
+        {
+            selected = oldest_front_(selected);
+        }
+        popped_item = std::move(*selected->front());
+        selected->pop_front();
+        return true;
+    }
+
+    // pop up to max_items. the consumer side state is guarded by consumer_mutex_,
+    // which is held only while popping (never while waiting).
+    size_t try_pop_bulk_(T *popped_items, size_t max_items)
+    {
+        std::lock_guard<std::mutex> consumer_lock(consumer_mutex_);
+        size_t n = 0;
+        while (n < max_items && try_pop_(popped_items[n]))
+        {
+            n++;
+        }
+        return n;
+    }
+
+    // the ring with the oldest front item (selected if none is older)
+    ring *oldest_front_(ring *selected)
+    {
+        for (auto &r : consumer_rings_)
+        {
+            T *front = r->front();
+            if (front != nullptr && front->time < selected->front()->time)
+            {
+                selected = r.get();
+            }
+        }
+        return selected;
+    }
+
+    // wait (by the wait policy) until some items were popped or timeout have passed.
+    // Return number of popped items
+    size_t wait_pop_(T *popped_items, size_t max_items, std::chrono::milliseconds wait_duration)
+    {
+        size_t n = try_pop_bulk_(popped_items, max_items);
+        if (n > 0)
+        {
+            return n;
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + wait_duration;
+        for (unsigned int round = 0; (n = try_pop_bulk_(popped_items, max_items)) == 0; round++)
+        {
+            if (wait_policy_.spins(round))
+            {
+                if (wait_policy::timed_out(round, deadline))
+                {
+                    return 0;
+                }
+                wait_policy_.backoff(round);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(park_mutex_);
+            park_(consumers_parked_);
+            bool signaled = push_cv_.wait_until(lock, deadline, [this] { return this->has_pending_(); });
+            consumers_parked_.fetch_sub(1, std::memory_order_relaxed);
+            if (!signaled)
+            {
+                return 0;
+            }
+        }
+        return n;
+    }
+
+    // called by a parked consumer (with park_mutex_ held, but not consumer_mutex_ -
+    // so the registered rings are read rather than the consumer side copy)
+    bool has_pending_()
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        for (auto &r : rings_)
+        {
+            if (!r->empty())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // announce a parked waiter (called with park_mutex_ held).
+    // the fence pairs with the one in wake_(): either the waiter sees the new
+    // state in its wait predicate, or the other side sees the waiter and notifies.
+    static void park_(std::atomic<size_t> &parked)
+    {
+        parked.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    void wake_(std::atomic<size_t> &parked, std::condition_variable &cv)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked.load(std::memory_order_relaxed) > 0)
+        {
+            std::lock_guard<std::mutex> lock(park_mutex_);
+            cv.notify_all();
+        }
+    }
+};
+
+} // namespace details
+} // namespace spdlog
@@ -8,19 +8,137 @@
 #endif
 
 #include <spdlog/common.h>
+#include <spdlog/async_logger.h>
+#include <algorithm>
 #include <cassert>
+#include <cstdio>
 
 namespace spdlog {
 namespace details {
 
-SPDLOG_INLINE thread_pool::thread_pool(size_t q_max_items, size_t threads_n, std::function<void()> on_thread_start)
-    : q_(q_max_items)
+SPDLOG_INLINE uint64_t logger_table::add(std::weak_ptr<async_logger> logger)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t index;
+    if (!free_.empty())
+    {
+        index = free_.back();
+        free_.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(entries_.size());
+        entries_.emplace_back();
+    }
+    entries_[index].logger = std::move(logger);
+    return make_id_(index, entries_[index].generation);
+}
+
+SPDLOG_INLINE void logger_table::retire(uint64_t id, std::shared_ptr<async_logger> copy)
+{
+    if (copy == nullptr)
+    {
+        release(id);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &e = entries_[static_cast<uint32_t>(id)];
+    if (make_id_(static_cast<uint32_t>(id), e.generation) == id)
+    {
+        e.retired = std::move(copy);
+    }
+    retired_cv_.notify_all();
+}
+
+SPDLOG_INLINE void logger_table::release(uint64_t id)
+{
+    std::shared_ptr<async_logger> retired; // destroyed after the mutex was released
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto index = static_cast<uint32_t>(id);
+        auto &e = entries_[index];
+        if (make_id_(index, e.generation) != id)
+        {
+            return;
+        }
+        retired = std::move(e.retired);
+        e.logger.reset();
+        e.generation = e.generation + 1 == 0 ? 1 : e.generation + 1;
+        free_.push_back(index);
+        retired_cv_.notify_all();
+    }
+}
+
+SPDLOG_INLINE std::shared_ptr<async_logger> logger_table::pin(uint64_t id)
+{
+    auto index = static_cast<uint32_t>(id);
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        auto &e = entries_[index];
+        if (make_id_(index, e.generation) != id)
+        {
+            return nullptr;
+        }
+        if (e.retired)
+        {
+            return e.retired;
+        }
+        if (auto logger = e.logger.lock())
+        {
+            return logger;
+        }
+        retired_cv_.wait(lock);
+    }
+}
+
+SPDLOG_INLINE thread_pool::thread_pool(size_t q_max_items, size_t threads_n, std::function<void()> on_thread_start,
+    async_queue_type queue_type, async_sharding sharding, async_wait_strategy wait_strategy)
+    : loggers_(std::make_shared<logger_table>())
+    , id_(next_pool_id_())
+    , shared_counters_(std::make_shared<producer_counters>())
 {
     if (threads_n == 0 || threads_n > 1000)
     {
         throw_spdlog_ex("spdlog::thread_pool(): invalid threads_n param (valid "
                         "range is 1-1000)");
     }
+
+    worker_states_.reset(new worker_state[threads_n]);
+    producers_.push_back(shared_counters_);
+    size_t n_queues = sharding == async_sharding::by_logger ? threads_n : 1;
+    size_t queue_items = (q_max_items + n_queues - 1) / n_queues;
+    auto policy = make_wait_policy_(wait_strategy);
+    for (size_t i = 0; i < n_queues; i++)
+    {
+        switch (queue_type)
+        {
+        case async_queue_type::lockfree:
+            queues_.push_back(details::make_unique<lockfree_q_type>(queue_items, policy));
+            break;
+        case async_queue_type::per_thread:
+        case async_queue_type::per_thread_ordered: {
+            size_t ring_items = per_thread_q_max_items;
+            queues_.push_back(details::make_unique<thread_local_q_type>((std::min)(queue_items, ring_items),
+                queue_type == async_queue_type::per_thread_ordered, policy, &async_msg_is_control));
+            break;
+        }
+        case async_queue_type::priority: {
+            std::vector<size_t> lanes_items(priority_lanes, (queue_items + priority_lanes - 2) / (priority_lanes - 1));
+            lanes_items[0] = priority_control_items;
+            queues_.push_back(details::make_unique<priority_q_type>(lanes_items, &async_msg_lane, policy));
+            break;
+        }
+        default:
+            queues_.push_back(details::make_unique<q_type>(queue_items, policy));
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < threads_n; i++)
+    {
+        worker_guards_.push_back(std::make_shared<worker_guard>());
+    }
     for (size_t i = 0; i < threads_n; i++)
     {
         /* 通常使用push_back()向容器中加入一个右值元素(临时对象)时，
@@ -31,107 +149,852 @@ SPDLOG_INLINE thread_pool::thread_pool(size_t q_max_items, size_t threads_n, std
          * （如果是拷贝的话，事后会自行销毁先前创建的这个元素）；
          * 而 emplace_back() 在实现时，则是直接在容器尾部创建这个元素，省去了拷贝或移动元素的过程。
          */
-        threads_.emplace_back([this, on_thread_start] {
+        auto guard = worker_guards_[i];
+        threads_.emplace_back([this, on_thread_start, i, guard] {
+#ifndef SPDLOG_NO_TLS
+            current_worker_index_() = i;
+#endif
             on_thread_start();
-            this->thread_pool::worker_loop_(); // 这里为什么要用this->thread_pool::worker_loop_(); 而不是worker_loop_()
+            this->thread_pool::worker_loop_(i); // 这里为什么要用this->thread_pool::worker_loop_(); 而不是worker_loop_()
+            {
+                std::lock_guard<std::mutex> guard_lock(guard->mutex);
+                if (guard->abandoned)
+                {
+                    return;
+                }
+            }
+            std::lock_guard<std::mutex> lock(this->exit_mutex_);
+            this->worker_states_[i].exited = true;
+            this->exit_cv_.notify_all();
         });
     }
+    publish_();
 }
 
+SPDLOG_INLINE thread_pool::thread_pool(size_t q_max_items, size_t threads_n, std::function<void()> on_thread_start,
+    async_queue_type queue_type, async_sharding sharding)
+    : thread_pool(q_max_items, threads_n, std::move(on_thread_start), queue_type, sharding,
+          queue_type == async_queue_type::blocking || queue_type == async_queue_type::priority ? async_wait_strategy::blocking
+                                                                                               : async_wait_strategy::adaptive)
+{}
+
+SPDLOG_INLINE thread_pool::thread_pool(
+    size_t q_max_items, size_t threads_n, std::function<void()> on_thread_start, async_queue_type queue_type)
+    : thread_pool(q_max_items, threads_n, std::move(on_thread_start), queue_type, async_sharding::none)
+{}
+
+SPDLOG_INLINE thread_pool::thread_pool(size_t q_max_items, size_t threads_n, std::function<void()> on_thread_start)
+    : thread_pool(q_max_items, threads_n, std::move(on_thread_start), async_queue_type::blocking)
+{}
+
 SPDLOG_INLINE thread_pool::thread_pool(size_t q_max_items, size_t threads_n)
     : thread_pool(q_max_items, threads_n, [] {})
 {}
 
-// message all threads to terminate gracefully join them
 SPDLOG_INLINE thread_pool::~thread_pool()
 {
     SPDLOG_TRY
     {
-        for (size_t i = 0; i < threads_.size(); i++)
         {
-            post_async_msg_(async_msg(async_msg_type::terminate), async_overflow_policy::block);
+            // let the threads that still hold counters know they are no longer needed
+            std::lock_guard<std::mutex> lock(producers_mutex_);
+            for (auto &counters : producers_)
+            {
+                counters->orphaned.store(true, std::memory_order_relaxed);
+            }
         }
-
-        for (auto &t : threads_)
+        // if shutdown() was called explicitly, the caller already got the count
+        bool reported = stopped_.load(std::memory_order_relaxed);
+        auto dropped = shutdown();
+        if (dropped > 0 && !reported)
         {
-            t.join();
+            std::fprintf(stderr, "[*** LOG ERROR ***] [thread_pool] {%zu messages dropped at shutdown}\n", dropped);
+        }
+        // the workers shutdown() gave up on (still busy after the shutdown timeout).
+        // the ones in a sink are detached, the others exit after their current batch.
+        for (size_t i = 0; i < threads_.size(); i++)
+        {
+            if (!threads_[i].joinable())
+            {
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> guard_lock(worker_guards_[i]->mutex);
+                worker_guards_[i]->abandoned = true;
+                if (worker_guards_[i]->in_sink)
+                {
+                    threads_[i].detach();
+                    continue;
+                }
+            }
+            threads_[i].join();
         }
     }
     SPDLOG_CATCH_ALL() {}
+    withdraw_();
 }
 
-void SPDLOG_INLINE thread_pool::post_log(async_logger_ptr &&worker_ptr, const details::log_msg &msg, async_overflow_policy overflow_policy)
+void SPDLOG_INLINE thread_pool::post_log(async_logger *worker_ptr, const details::log_msg &msg, async_overflow_policy overflow_policy)
 {
-    async_msg async_m(std::move(worker_ptr), async_msg_type::log, msg);
-    post_async_msg_(std::move(async_m), overflow_policy);
+    post_deferred(worker_ptr, msg, nullptr, 0, overflow_policy);
 }
 
-void SPDLOG_INLINE thread_pool::post_flush(async_logger_ptr &&worker_ptr, async_overflow_policy overflow_policy)
+// like post_log, but the worker formats the payload using format_fn (if not null)
+void SPDLOG_INLINE thread_pool::post_deferred(async_logger *worker_ptr, const details::log_msg &msg, deferred_format_fn format_fn,
+    size_t format_size, async_overflow_policy overflow_policy)
 {
-    post_async_msg_(async_msg(std::move(worker_ptr), async_msg_type::flush), overflow_policy);
+#ifndef SPDLOG_NO_TLS
+    // reuse the thread's message (and the capacity of its buffer) for every post.
+    // the queue slots copy it into their own buffers.
+    static thread_local async_msg async_m;
+    static_cast<log_msg_buffer &>(async_m) = msg;
+    async_m.msg_type = async_msg_type::log;
+    async_m.logger_id = worker_ptr->registered_id_();
+#else
+    async_msg async_m(worker_ptr->registered_id_(), async_msg_type::log, msg);
+#endif
+    async_m.format_fn = format_fn;
+    async_m.format_size = format_size;
+    post_async_msg_(queue_index_(worker_ptr), std::move(async_m), overflow_policy);
+}
+
+void SPDLOG_INLINE thread_pool::post_flush(
+    async_logger *worker_ptr, async_overflow_policy overflow_policy, std::unique_ptr<flush_completion> completion)
+{
+    async_msg flush_msg(worker_ptr->registered_id_(), async_msg_type::flush);
+    flush_msg.flush_done = std::move(completion);
+    post_async_msg_(queue_index_(worker_ptr), std::move(flush_msg), overflow_policy);
+}
+
+void SPDLOG_INLINE thread_pool::post_retire(const async_logger *worker_ptr, uint64_t id)
+{
+    std::unique_lock<std::mutex> lock(retires_mutex_);
+    if (finished_)
+    {
+        lock.unlock();
+        loggers_->release(id);
+        return;
+    }
+    // also while shutting down - the workers may still be draining the logger's messages
+    pending_retire retire{queue_index_(worker_ptr), async_msg(id, async_msg_type::retire)};
+    shared_counters_->enqueued.fetch_add(1, std::memory_order_relaxed);
+    if (!queues_[retire.queue_index]->try_enqueue(std::move(retire.msg)))
+    {
+        shared_counters_->enqueued.fetch_sub(1, std::memory_order_relaxed);
+        pending_retires_.push_back(std::move(retire));
+        retires_pending_.store(true, std::memory_order_release);
+    }
+}
+
+std::shared_ptr<logger_table> SPDLOG_INLINE thread_pool::loggers() const
+{
+    return loggers_;
 }
 
 size_t SPDLOG_INLINE thread_pool::overrun_counter()
 {
-    return q_.overrun_counter();
+    return stats().overrun;
+}
+
+size_t SPDLOG_INLINE thread_pool::dropped_counter()
+{
+    return stats().dropped;
 }
 
 size_t SPDLOG_INLINE thread_pool::queue_size()
 {
-    return q_.size();
+    size_t total = 0;
+    for (auto &q : queues_)
+    {
+        total += q->size();
+    }
+    return total;
+}
+
+thread_pool_stats SPDLOG_INLINE thread_pool::stats() const
+{
+    thread_pool_stats result;
+    // read the worker side first, so the depth is not negative
+    for (size_t i = 0; i < threads_.size(); i++)
+    {
+        result.dequeued += worker_states_[i].dequeued.load(std::memory_order_relaxed);
+        result.max_queue_depth = (std::max)(result.max_queue_depth, worker_states_[i].max_depth.load(std::memory_order_relaxed));
+    }
+    std::chrono::nanoseconds::rep blocked_ns = 0;
+    {
+        std::lock_guard<std::mutex> lock(producers_mutex_);
+        for (auto &counters : producers_)
+        {
+            result.overrun += counters->overrun.load(std::memory_order_relaxed);
+            result.dropped += counters->dropped.load(std::memory_order_relaxed);
+            result.enqueued += counters->enqueued.load(std::memory_order_relaxed);
+            blocked_ns += counters->blocked_ns.load(std::memory_order_relaxed);
+        }
+    }
+    result.dequeued += shutdown_dequeued_.load(std::memory_order_relaxed);
+    result.blocked_time = std::chrono::nanoseconds(blocked_ns);
+    auto gone = result.dequeued + result.overrun;
+    result.queue_depth = result.enqueued > gone ? result.enqueued - gone : 0;
+    result.max_queue_depth = (std::max)(result.max_queue_depth, result.queue_depth);
+    result.shutdown_dropped = shutdown_dropped_.load(std::memory_order_relaxed);
+    return result;
+}
+
+void SPDLOG_INLINE thread_pool::report_stats_every(std::chrono::seconds interval, std::function<void(const thread_pool_stats &)> callback)
+{
+    std::lock_guard<std::mutex> lock(stats_reporter_mutex_);
+    stats_reporter_.reset();
+    auto clbk = [this, callback]() { callback(this->stats()); };
+    stats_reporter_ = details::make_unique<periodic_worker>(clbk, interval);
 }
 
-void SPDLOG_INLINE thread_pool::post_async_msg_(async_msg &&new_msg, async_overflow_policy overflow_policy)
+void SPDLOG_INLINE thread_pool::set_shutdown_policy(async_shutdown_policy policy, std::chrono::milliseconds timeout)
 {
-    if (overflow_policy == async_overflow_policy::block)
+    std::lock_guard<std::mutex> lock(shutdown_mutex_);
+    shutdown_policy_ = policy;
+    shutdown_timeout_ = timeout;
+}
+
+size_t SPDLOG_INLINE thread_pool::shutdown()
+{
+    std::lock_guard<std::mutex> lock(shutdown_mutex_);
+    if (stopped_.load(std::memory_order_relaxed))
+    {
+        return shutdown_dropped_.load(std::memory_order_relaxed);
+    }
+    // from now on posts are dropped - no producer may block on a queue the workers left
+    stopped_.store(true, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> reporter_lock(stats_reporter_mutex_);
+        stats_reporter_.reset();
+    }
+
+    // per thread queues are not ordered with each other, so a terminate
+    // message could overtake messages posted earlier by other threads.
+    // let the workers drain the queues first.
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    if (shutdown_policy_ == async_shutdown_policy::drain_until)
     {
-        q_.enqueue(std::move(new_msg));
+        deadline = std::chrono::steady_clock::now() + shutdown_timeout_;
     }
     else
     {
-        q_.enqueue_nowait(std::move(new_msg));
+        draining_.store(true, std::memory_order_relaxed);
+    }
+    bool drained = true;
+    for (auto &q : queues_)
+    {
+        drained = q->wait_dequeued(deadline) && drained;
+    }
+    if (!drained)
+    {
+        dropping_.store(true, std::memory_order_relaxed);
+    }
+
+    // no barrier may be posted after the terminate messages. the workers exit after their
+    // current batch - the terminate messages only wake the waiting ones, so a full queue
+    // (the deadline passed) does not block them.
+    std::lock_guard<std::mutex> call_lock(barrier_call_mutex_);
+    terminate_.store(true, std::memory_order_release);
+    for (size_t i = 0; i < threads_.size(); i++)
+    {
+        post_control_(i % queues_.size(), async_msg(async_msg_type::terminate));
+    }
+
+    // give the workers (dropping the rest of their batches if not drained) another shutdown
+    // timeout to exit. the ones still busy (in a sink) are left to the destructor.
+    if (shutdown_policy_ == async_shutdown_policy::drain_until)
+    {
+        deadline = std::chrono::steady_clock::now() + shutdown_timeout_;
+    }
+    std::vector<bool> exited(threads_.size(), false);
+    {
+        std::unique_lock<std::mutex> exit_lock(exit_mutex_);
+        auto all_exited = [this, &exited] {
+            bool all = true;
+            for (size_t i = 0; i < this->threads_.size(); i++)
+            {
+                exited[i] = this->worker_states_[i].exited;
+                all = all && exited[i];
+            }
+            return all;
+        };
+        if (deadline == std::chrono::steady_clock::time_point::max())
+        {
+            exit_cv_.wait(exit_lock, all_exited);
+        }
+        else
+        {
+            exit_cv_.wait_until(exit_lock, deadline, all_exited);
+        }
+    }
+    size_t busy = 0;
+    for (size_t i = 0; i < threads_.size(); i++)
+    {
+        if (exited[i])
+        {
+            threads_[i].join();
+        }
+        else
+        {
+            busy++;
+        }
+    }
+    if (busy > 0)
+    {
+        dropping_.store(true, std::memory_order_relaxed);
+        std::fprintf(stderr, "[*** LOG ERROR ***] [thread_pool] {%zu workers still busy after the shutdown timeout}\n", busy);
+    }
+
+    release_pending_retires_();
+    drop_left_messages_();
+    return shutdown_dropped_.load(std::memory_order_relaxed);
+}
+
+// wait until the messages posted so far left the queues, then make every worker
+// pass a barrier - so the batches they were processing are done as well.
+// the barriers are posted one by one, each to be taken by a different worker
+// (with a shared queue, a worker waiting at the barrier cannot pop the next one).
+void SPDLOG_INLINE thread_pool::wait_processed()
+{
+    if (is_worker_thread_())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> call_lock(barrier_call_mutex_);
+    if (stopped_.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    for (auto &q : queues_)
+    {
+        q->wait_dequeued(std::chrono::steady_clock::time_point::max());
+    }
+
+    std::unique_lock<std::mutex> lock(barrier_mutex_);
+    for (size_t i = 0; i < threads_.size(); i++)
+    {
+        lock.unlock();
+        post_async_msg_(i % queues_.size(), async_msg(async_msg_type::barrier), async_overflow_policy::block);
+        lock.lock();
+        barrier_cv_.wait(lock, [this, i] { return this->barrier_arrived_ == i + 1; });
+    }
+    barrier_arrived_ = 0;
+    barrier_generation_++;
+    barrier_cv_.notify_all();
+}
+
+void SPDLOG_INLINE thread_pool::for_each_pending_unsafe(void (*fun)(const async_msg &msg, void *ctx), void *ctx)
+{
+    for (auto &q : queues_)
+    {
+        q->for_each_unsafe(fun, ctx);
+    }
+    // taken from the queues, maybe not written yet
+    for (size_t i = 0; i < threads_.size(); i++)
+    {
+        auto &state = worker_states_[i];
+        auto size = state.batch_size.load(std::memory_order_acquire);
+        auto *batch = state.batch.load(std::memory_order_acquire);
+        for (size_t j = 0; batch != nullptr && j < size; j++)
+        {
+            fun(batch[j], ctx);
+        }
+    }
+}
+
+void SPDLOG_INLINE thread_pool::for_each_published_pending_unsafe(void (*fun)(const async_msg &msg, void *ctx), void *ctx)
+{
+    auto *published = published_();
+    for (size_t i = 0; i < published_max; i++)
+    {
+        auto *tp = published[i].load(std::memory_order_acquire);
+        if (tp != nullptr)
+        {
+            tp->for_each_pending_unsafe(fun, ctx);
+        }
+    }
+}
+
+// zero initialized at load time - no guard, so it is safe to read from a signal handler
+SPDLOG_INLINE std::atomic<thread_pool *> *thread_pool::published_()
+{
+    static std::atomic<thread_pool *> published[published_max];
+    return published;
+}
+
+// the pools that did not fit in the table are not visited
+SPDLOG_INLINE void thread_pool::publish_()
+{
+    auto *published = published_();
+    for (size_t i = 0; i < published_max; i++)
+    {
+        thread_pool *expected = nullptr;
+        if (published[i].compare_exchange_strong(expected, this, std::memory_order_release))
+        {
+            return;
+        }
+    }
+}
+
+SPDLOG_INLINE void thread_pool::withdraw_()
+{
+    auto *published = published_();
+    for (size_t i = 0; i < published_max; i++)
+    {
+        thread_pool *expected = this;
+        if (published[i].compare_exchange_strong(expected, nullptr, std::memory_order_release))
+        {
+            return;
+        }
+    }
+}
+
+size_t SPDLOG_INLINE thread_pool::current_worker_index()
+{
+    return current_worker_index_();
+}
+
+SPDLOG_INLINE size_t &thread_pool::current_worker_index_()
+{
+#ifndef SPDLOG_NO_TLS
+    static thread_local size_t index = static_cast<size_t>(-1);
+#else
+    // not tracked without thread local storage
+    static size_t index = static_cast<size_t>(-1);
+#endif
+    return index;
+}
+
+SPDLOG_INLINE wait_policy thread_pool::make_wait_policy_(async_wait_strategy wait_strategy)
+{
+    switch (wait_strategy)
+    {
+    case async_wait_strategy::adaptive:
+        return wait_policy::adaptive();
+    case async_wait_strategy::busy_spin:
+        return wait_policy::busy_spin();
+    default:
+        return wait_policy::blocking();
+    }
+}
+
+// the queue of the logger's worker - by the logger's name hash when sharded
+size_t SPDLOG_INLINE thread_pool::queue_index_(const async_logger *worker_ptr) const
+{
+    return queues_.size() == 1 ? 0 : worker_ptr->name_hash_ % queues_.size();
+}
+
+void SPDLOG_INLINE thread_pool::post_async_msg_(size_t queue_index, async_msg &&new_msg, async_overflow_policy overflow_policy)
+{
+    auto &counters = this_thread_counters_();
+    if (stopped_.load(std::memory_order_relaxed))
+    {
+        shutdown_dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // counted before the push on every path, so a worker never takes more than was enqueued
+    auto &q = queues_[queue_index];
+    add_<size_t>(counters.enqueued, 1);
+    if (!q->try_enqueue(std::move(new_msg)))
+    {
+        if (overflow_policy == async_overflow_policy::discard_new)
+        {
+            // not enqueued after all (adding -1 wraps around)
+            add_<size_t>(counters.enqueued, static_cast<size_t>(-1));
+            add_<size_t>(counters.dropped, 1);
+        }
+        else if (overflow_policy == async_overflow_policy::block)
+        {
+            auto start = std::chrono::steady_clock::now();
+            q->enqueue(std::move(new_msg));
+            auto blocked = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+            add_<std::chrono::nanoseconds::rep>(counters.blocked_ns, blocked.count());
+        }
+        else
+        {
+            add_<size_t>(counters.overrun, q->enqueue_nowait(std::move(new_msg)));
+        }
+    }
+}
+
+// post the thread pool's own message, also after it was stopped
+bool SPDLOG_INLINE thread_pool::post_control_(size_t queue_index, async_msg &&new_msg)
+{
+    shared_counters_->enqueued.fetch_add(1, std::memory_order_relaxed);
+    if (queues_[queue_index]->try_enqueue(std::move(new_msg)))
+    {
+        return true;
+    }
+    shared_counters_->enqueued.fetch_sub(1, std::memory_order_relaxed);
+    return false;
+}
+
+// the retire messages keep their time, so the per thread queue still orders them after
+// the messages logged ahead of them
+void SPDLOG_INLINE thread_pool::post_pending_retires_()
+{
+    std::lock_guard<std::mutex> lock(retires_mutex_);
+    for (auto it = pending_retires_.begin(); it != pending_retires_.end();)
+    {
+        shared_counters_->enqueued.fetch_add(1, std::memory_order_relaxed);
+        if (queues_[it->queue_index]->try_enqueue(std::move(it->msg)))
+        {
+            it = pending_retires_.erase(it);
+        }
+        else
+        {
+            shared_counters_->enqueued.fetch_sub(1, std::memory_order_relaxed);
+            ++it;
+        }
+    }
+    retires_pending_.store(!pending_retires_.empty(), std::memory_order_relaxed);
+}
+
+// the messages left behind the terminate messages. the entries of the retired loggers
+// among them are freed, the log messages counted as dropped.
+SPDLOG_INLINE void thread_pool::drop_left_messages_()
+{
+    std::vector<async_msg> left(batch_max_items);
+    for (auto &q : queues_)
+    {
+        size_t count;
+        while ((count = q->dequeue_bulk(left.data(), left.size(), std::chrono::milliseconds::zero())) > 0)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                shutdown_dequeued_.fetch_add(1, std::memory_order_relaxed);
+                if (left[i].msg_type == async_msg_type::retire)
+                {
+                    loggers_->release(left[i].logger_id);
+                }
+                else if (left[i].msg_type != async_msg_type::terminate)
+                {
+                    shutdown_dropped_.fetch_add(1, std::memory_order_relaxed);
+                }
+                left[i].flush_done.reset();
+            }
+        }
+    }
+}
+
+SPDLOG_INLINE void thread_pool::release_pending_retires_()
+{
+    std::vector<pending_retire> pending;
+    {
+        std::lock_guard<std::mutex> lock(retires_mutex_);
+        finished_ = true;
+        pending.swap(pending_retires_);
+        retires_pending_.store(false, std::memory_order_relaxed);
+    }
+    for (auto &retire : pending)
+    {
+        loggers_->release(retire.msg.logger_id);
+    }
+}
+
+// the stats counters of the calling thread. registered on its first post to this pool.
+SPDLOG_INLINE thread_pool::producer_counters &thread_pool::this_thread_counters_()
+{
+#ifndef SPDLOG_NO_TLS
+    struct counters_handle
+    {
+        size_t pool_id;
+        std::shared_ptr<producer_counters> counters;
+    };
+    static thread_local std::vector<counters_handle> handles;
+    for (auto &h : handles)
+    {
+        if (h.pool_id == id_)
+        {
+            return *h.counters;
+        }
+    }
+
+    // first post from this thread - forget counters of destroyed pools and register new ones.
+    for (auto it = handles.begin(); it != handles.end();)
+    {
+        it = it->counters->orphaned.load(std::memory_order_relaxed) ? handles.erase(it) : std::next(it);
+    }
+    auto counters = std::make_shared<producer_counters>();
+    {
+        std::lock_guard<std::mutex> lock(producers_mutex_);
+        producers_.push_back(counters);
     }
+    handles.push_back(counters_handle{id_, counters});
+    return *counters;
+#else
+    return *shared_counters_;
+#endif
+}
+
+template<typename V>
+SPDLOG_INLINE void thread_pool::add_(std::atomic<V> &counter, V n)
+{
+#ifndef SPDLOG_NO_TLS
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+#else
+    counter.fetch_add(n, std::memory_order_relaxed);
+#endif
+}
+
+SPDLOG_INLINE size_t thread_pool::next_pool_id_()
+{
+    static std::atomic<size_t> last_id{0};
+    return ++last_id;
 }
 
 // 处理数据循环
-void SPDLOG_INLINE thread_pool::worker_loop_()
+void SPDLOG_INLINE thread_pool::worker_loop_(size_t worker_index)
 {
-    while (process_next_msg_()) {}
+    worker_context ctx;
+    ctx.worker_index = worker_index;
+    ctx.queue_index = worker_index % queues_.size();
+    ctx.batch.resize(batch_max_items);
+    ctx.run.reserve(batch_max_items);
+    ctx.guard = worker_guards_[worker_index];
+    worker_states_[worker_index].batch.store(ctx.batch.data(), std::memory_order_release);
+    while (process_next_msg_(ctx) && !terminate_.load(std::memory_order_acquire))
+    {
+        if (retires_pending_.load(std::memory_order_acquire))
+        {
+            post_pending_retires_();
+        }
+        if (!ctx.releases.empty())
+        {
+            release_loggers_(ctx);
+        }
+        if (ctx.batch.size() < drain_batch_max_items && draining_.load(std::memory_order_relaxed))
+        {
+            auto &state = worker_states_[worker_index];
+            state.batch_size.store(0, std::memory_order_release);
+            state.batch.store(nullptr, std::memory_order_release);
+            ctx.batch.resize(drain_batch_max_items);
+            state.batch.store(ctx.batch.data(), std::memory_order_release);
+            ctx.run.reserve(drain_batch_max_items);
+        }
+    }
+    if (ctx.abandoned)
+    {
+        return;
+    }
+
+    // the other workers may still have messages of these loggers - retire them again
+    // (for a worker still running, or for shutdown() to release)
+    for (auto &pending : ctx.releases)
+    {
+        std::unique_lock<std::mutex> lock(retires_mutex_);
+        if (finished_)
+        {
+            lock.unlock();
+            loggers_->release(pending.logger_id);
+            continue;
+        }
+        pending_retires_.push_back(pending_retire{ctx.queue_index, async_msg(pending.logger_id, async_msg_type::retire)});
+        retires_pending_.store(true, std::memory_order_release);
+    }
 }
 
-// process next message in the queue
+// process next batch of messages in the queue.
+// consecutive log messages of the same logger are passed to its sinks at once.
 // return true if this thread should still be active (while no terminate msg
 // was received)
-bool SPDLOG_INLINE thread_pool::process_next_msg_()
+bool SPDLOG_INLINE thread_pool::process_next_msg_(worker_context &ctx)
 {
-    async_msg incoming_async_msg;
-    bool dequeued = q_.dequeue_for(incoming_async_msg, std::chrono::seconds(10));
-    if (!dequeued)
+    auto &batch = ctx.batch;
+    auto &run = ctx.run;
+    auto &state = worker_states_[ctx.worker_index];
+    state.batches.fetch_add(1, std::memory_order_acq_rel);
+    auto &q = queues_[ctx.queue_index];
+    // the previous batch is overwritten
+    state.batch_size.store(0, std::memory_order_release);
+    size_t count = q->dequeue_bulk(batch.data(), batch.size(), std::chrono::seconds(10));
+    state.batch_size.store(count, std::memory_order_release);
+    if (count > 0)
     {
-        return true;
+        // the depth of the queue before the pop (as seen by this worker)
+        auto depth = count + q->size();
+        add_<size_t>(state.dequeued, count);
+        if (depth > state.max_depth.load(std::memory_order_relaxed))
+        {
+            state.max_depth.store(depth, std::memory_order_relaxed);
+        }
     }
 
-    switch (incoming_async_msg.msg_type)
+    size_t terminate_count = 0;
+    for (size_t i = 0; i < count;)
     {
-    case async_msg_type::log: {
-        incoming_async_msg.worker_ptr->backend_sink_it_(incoming_async_msg);
-        return true;
+        auto &incoming_async_msg = batch[i];
+        switch (incoming_async_msg.msg_type)
+        {
+        case async_msg_type::log: {
+            if (dropping_.load(std::memory_order_relaxed))
+            {
+                shutdown_dropped_.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+            auto logger_id = incoming_async_msg.logger_id;
+            auto worker = loggers_->pin(logger_id);
+            if (!enter_sink_(ctx))
+            {
+                return false;
+            }
+            run.clear();
+            for (; i < count && batch[i].msg_type == async_msg_type::log && batch[i].logger_id == logger_id; i++)
+            {
+                if (worker == nullptr || (batch[i].format_fn != nullptr && !worker->backend_format_(batch[i], ctx.scratch)))
+                {
+                    continue;
+                }
+                run.push_back(batch[i]);
+            }
+            if (worker != nullptr)
+            {
+                worker->backend_sink_batch_(run.data(), run.size());
+            }
+            if (!leave_sink_(ctx))
+            {
+                return false;
+            }
+            continue;
+        }
+        case async_msg_type::flush: {
+            if (auto worker = loggers_->pin(incoming_async_msg.logger_id))
+            {
+                if (!enter_sink_(ctx))
+                {
+                    return false;
+                }
+                worker->backend_flush_();
+                if (incoming_async_msg.flush_done)
+                {
+                    incoming_async_msg.flush_done->complete(true);
+                }
+                if (!leave_sink_(ctx))
+                {
+                    return false;
+                }
+            }
+            incoming_async_msg.flush_done.reset();
+            break;
+        }
+
+        case async_msg_type::retire: {
+            retire_logger_(ctx, incoming_async_msg.logger_id);
+            break;
+        }
+
+        case async_msg_type::terminate: {
+            terminate_count++;
+            break;
+        }
+
+        case async_msg_type::barrier: {
+            arrive_at_barrier_();
+            break;
+        }
+
+        default: {
+            assert(false);
+        }
+        }
+        i++;
     }
-    case async_msg_type::flush: {
-        incoming_async_msg.worker_ptr->backend_flush_();
+    state.batches.fetch_add(1, std::memory_order_release);
+
+    if (terminate_count == 0)
+    {
         return true;
     }
 
-    case async_msg_type::terminate: {
-        return false;
+    // leave the extra terminate messages to the other workers
+    for (size_t i = 1; i < terminate_count; i++)
+    {
+        post_control_(ctx.queue_index, async_msg(async_msg_type::terminate));
     }
+    return false;
+}
 
-    default: {
-        assert(false);
+bool SPDLOG_INLINE thread_pool::enter_sink_(worker_context &ctx)
+{
+    std::lock_guard<std::mutex> lock(ctx.guard->mutex);
+    ctx.abandoned = ctx.guard->abandoned;
+    ctx.guard->in_sink = !ctx.abandoned;
+    return !ctx.abandoned;
+}
+
+// the destructor may have detached this worker meanwhile (and the pool be gone)
+bool SPDLOG_INLINE thread_pool::leave_sink_(worker_context &ctx)
+{
+    std::lock_guard<std::mutex> lock(ctx.guard->mutex);
+    ctx.guard->in_sink = false;
+    ctx.abandoned = ctx.guard->abandoned;
+    return !ctx.abandoned;
+}
+
+void SPDLOG_INLINE thread_pool::arrive_at_barrier_()
+{
+    std::unique_lock<std::mutex> lock(barrier_mutex_);
+    auto generation = barrier_generation_;
+    barrier_arrived_++;
+    barrier_cv_.notify_all();
+    barrier_cv_.wait(lock, [this, generation] { return this->barrier_generation_ != generation; });
+}
+
+void SPDLOG_INLINE thread_pool::retire_logger_(worker_context &ctx, uint64_t logger_id)
+{
+    // the logger's messages are only in this worker's queue, ahead of the retire message
+    if (threads_.size() == queues_.size())
+    {
+        loggers_->release(logger_id);
+        return;
     }
+    pending_release pending;
+    pending.logger_id = logger_id;
+    for (size_t i = 0; i < threads_.size(); i++)
+    {
+        pending.batches.push_back(worker_states_[i].batches.load(std::memory_order_acquire));
     }
+    ctx.releases.push_back(std::move(pending));
+}
 
-    return true;
+void SPDLOG_INLINE thread_pool::release_loggers_(worker_context &ctx)
+{
+    for (auto it = ctx.releases.begin(); it != ctx.releases.end();)
+    {
+        bool done = true;
+        for (size_t i = 0; i < it->batches.size() && done; i++)
+        {
+            // even - the worker had no batch when the retire message was taken
+            auto taken = it->batches[i];
+            done = i == ctx.worker_index || taken % 2 == 0 || worker_states_[i].batches.load(std::memory_order_acquire) != taken;
+        }
+        if (done)
+        {
+            loggers_->release(it->logger_id);
+            it = ctx.releases.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+bool SPDLOG_INLINE thread_pool::is_worker_thread_() const
+{
+    auto this_id = std::this_thread::get_id();
+    for (auto &t : threads_)
+    {
+        if (t.get_id() == this_id)
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
 } // namespace details
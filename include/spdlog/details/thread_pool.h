@@ -3,28 +3,114 @@
 
 #pragma once
 
+#include <spdlog/details/deferred_format.h>
 #include <spdlog/details/log_msg_buffer.h>
 #include <spdlog/details/mpmc_blocking_q.h>
+#include <spdlog/details/mpmc_lockfree_q.h>
+#include <spdlog/details/mpmc_priority_q.h>
+#include <spdlog/details/thread_local_q.h>
 #include <spdlog/details/os.h>
+#include <spdlog/details/periodic_worker.h>
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
 #include <functional>
+#include <future>
 
 namespace spdlog {
 class async_logger;
 
 namespace details {
 
-using async_logger_ptr = std::shared_ptr<spdlog::async_logger>;
-
 enum class async_msg_type
 {
     log,
     flush,
-    terminate
+    terminate,
+    barrier,
+    retire
+};
+
+// completes the future of an async flush request - with true once the sinks were flushed,
+// or with false if the request was dropped (overrun, or never enqueued) before that.
+class flush_completion
+{
+public:
+    flush_completion() = default;
+    flush_completion(const flush_completion &) = delete;
+    flush_completion &operator=(const flush_completion &) = delete;
+
+    ~flush_completion()
+    {
+        complete(false);
+    }
+
+    std::future<bool> get_future()
+    {
+        return promise_.get_future();
+    }
+
+    void complete(bool flushed)
+    {
+        if (!completed_)
+        {
+            completed_ = true;
+            promise_.set_value(flushed);
+        }
+    }
+
+private:
+    std::promise<bool> promise_;
+    bool completed_ = false;
+};
+
+// async loggers posting to a thread pool. the queued messages reference their logger
+// by its id here (index and generation of its entry) rather than by a pointer, so no
+// reference counting per message. a logger destroyed while its messages are still
+// queued leaves a copy of itself in its entry to process them, until the retire
+// message it posted behind them frees the entry. messages of a freed entry are dropped.
+// not free of read-modify-writes yet: a post still locks the logger's weak_ptr to the
+// pool (keeping the pool alive meanwhile), and the workers pin the logger of each run
+// of messages under the table's mutex.
+class SPDLOG_API logger_table
+{
+public:
+    // Return the id of the new entry (never 0)
+    uint64_t add(std::weak_ptr<async_logger> logger);
+
+    // the logger was destroyed - its queued messages go to the copy (or are dropped if null)
+    void retire(uint64_t id, std::shared_ptr<async_logger> copy);
+
+    // free the entry. its generation changes, so messages still referencing it are dropped
+    void release(uint64_t id);
+
+    // the logger to process the entry's messages with, or null if the entry was freed.
+    // waits if the logger is being destroyed at the moment (until it retired).
+    std::shared_ptr<async_logger> pin(uint64_t id);
+
+private:
+    struct entry
+    {
+        std::weak_ptr<async_logger> logger;
+        std::shared_ptr<async_logger> retired;
+        uint32_t generation = 1;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable retired_cv_;
+    std::vector<entry> entries_;
+    std::vector<uint32_t> free_;
+
+    static uint64_t make_id_(uint32_t index, uint32_t generation)
+    {
+        return (static_cast<uint64_t>(generation) << 32) | index;
+    }
 };
 
 #include <spdlog/details/log_msg_buffer.h>
@@ -33,7 +119,13 @@ enum class async_msg_type
 struct async_msg : log_msg_buffer
 {
     async_msg_type msg_type{async_msg_type::log};
-    async_logger_ptr worker_ptr;
+    uint64_t logger_id{0}; // see logger_table. 0 for the thread pool's own messages
+    // deferred formatting - if set, the payload holds the format string
+    // (of format_size bytes) followed by the raw args.
+    deferred_format_fn format_fn{nullptr};
+    size_t format_size{0};
+    // flush messages only - set if someone waits for the flush
+    std::unique_ptr<flush_completion> flush_done;
 
     async_msg() = default;
     ~async_msg() = default;
@@ -46,14 +138,20 @@ struct async_msg : log_msg_buffer
     async_msg(async_msg &&other)
         : log_msg_buffer(std::move(other))
         , msg_type(other.msg_type)
-        , worker_ptr(std::move(other.worker_ptr))
+        , logger_id(other.logger_id)
+        , format_fn(other.format_fn)
+        , format_size(other.format_size)
+        , flush_done(std::move(other.flush_done))
     {}
 
     async_msg &operator=(async_msg &&other)
     {
         *static_cast<log_msg_buffer *>(this) = std::move(other);
         msg_type = other.msg_type;
-        worker_ptr = std::move(other.worker_ptr);
+        logger_id = other.logger_id;
+        format_fn = other.format_fn;
+        format_size = other.format_size;
+        flush_done = std::move(other.flush_done);
         return *this;
     }
 #else // (_MSC_VER) && _MSC_VER <= 1800
@@ -62,21 +160,82 @@ struct async_msg : log_msg_buffer
 #endif
 
     // construct from log_msg with given type
-    async_msg(async_logger_ptr &&worker, async_msg_type the_type, const details::log_msg &m)
+    async_msg(uint64_t logger, async_msg_type the_type, const details::log_msg &m)
         : log_msg_buffer{m}
         , msg_type{the_type}
-        , worker_ptr{std::move(worker)}
+        , logger_id{logger}
     {}
 
-    async_msg(async_logger_ptr &&worker, async_msg_type the_type)
+    // control message. stamped with the current time, so the ordered per thread
+    // queue does not merge it ahead of the messages logged before it.
+    async_msg(uint64_t logger, async_msg_type the_type)
         : log_msg_buffer{}
         , msg_type{the_type}
-        , worker_ptr{std::move(worker)}
-    {}
+        , logger_id{logger}
+    {
+        time = log_clock::now();
+    }
 
     explicit async_msg(async_msg_type the_type)
-        : async_msg{nullptr, the_type}
+        : async_msg{0, the_type}
     {}
+
+    // replace the payload with the formatted message. scratch is used as temporary storage.
+    void format_deferred(memory_buf_t &scratch)
+    {
+        scratch.clear();
+        scratch.append(logger_name.begin(), logger_name.end());
+        format_fn(string_view_t(payload.data(), format_size), payload.data() + format_size, scratch);
+
+        log_msg formatted_msg(*this);
+        formatted_msg.logger_name = string_view_t(scratch.data(), logger_name.size());
+        formatted_msg.payload = string_view_t(scratch.data() + logger_name.size(), scratch.size() - logger_name.size());
+        log_msg_buffer::operator=(formatted_msg);
+        format_fn = nullptr;
+        format_size = 0;
+    }
+};
+
+// lane of a message in the priority queue: control messages, then by severity
+inline size_t async_msg_lane(const async_msg &msg)
+{
+    if (msg.msg_type != async_msg_type::log)
+    {
+        return 0;
+    }
+    switch (msg.level)
+    {
+    case level::trace:
+    case level::debug:
+        return 3;
+    case level::info:
+    case level::warn:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+// the thread pool's own and flush messages. the per thread queue merges them by time,
+// so they are not taken before the messages logged ahead of them by other threads.
+inline bool async_msg_is_control(const async_msg &msg)
+{
+    return msg.msg_type != async_msg_type::log;
+}
+
+// counters of a thread pool, in messages (log, flush and the pool's own control messages).
+// summed from the counters of each producer thread and worker without stopping them,
+// so they are only approximately consistent with each other.
+struct thread_pool_stats
+{
+    size_t enqueued = 0;                        // posted to the queues
+    size_t dequeued = 0;                        // taken by the workers
+    size_t overrun = 0;                         // lost because the queue was full (async_overflow_policy::overrun_oldest)
+    size_t dropped = 0;                         // not enqueued because the queue was full (async_overflow_policy::discard_new)
+    std::chrono::nanoseconds blocked_time{0};   // total time producers waited for room (async_overflow_policy::block)
+    size_t queue_depth = 0;                     // messages in the queues
+    size_t max_queue_depth = 0;                 // highest queue_depth seen by the workers
+    size_t shutdown_dropped = 0;                // dropped by the shutdown, or posted after it (see thread_pool::set_shutdown_policy())
 };
 
 class SPDLOG_API thread_pool
@@ -84,34 +243,244 @@ class SPDLOG_API thread_pool
 public:
     using item_type = async_msg;  // 最终放入的数据
     using q_type = details::mpmc_blocking_queue<item_type>;
+    using lockfree_q_type = details::mpmc_lockfree_queue<item_type>;
+    using thread_local_q_type = details::thread_local_queue<item_type>;
+    using priority_q_type = details::mpmc_priority_queue<item_type>;
+
+    // number of lanes of the priority queue (see async_msg_lane()). the log message lanes
+    // share the queue capacity, the control lane holds priority_control_items.
+    static const size_t priority_lanes = 4;
+    static const size_t priority_control_items = 64;
 
+    // capacity of the ring of each producer thread with async_queue_type::per_thread(_ordered).
+    // every thread that logs allocates one, so it is not sized by q_max_items (unless smaller).
+    static const size_t per_thread_q_max_items = 1024;
+
+    // with async_sharding::by_logger each worker gets its own queue of q_max_items / threads_n items
+    thread_pool(size_t q_max_items, size_t threads_n, std::function<void()> on_thread_start, async_queue_type queue_type,
+        async_sharding sharding, async_wait_strategy wait_strategy);
+    thread_pool(size_t q_max_items, size_t threads_n, std::function<void()> on_thread_start, async_queue_type queue_type,
+        async_sharding sharding);
+    thread_pool(size_t q_max_items, size_t threads_n, std::function<void()> on_thread_start, async_queue_type queue_type);
     thread_pool(size_t q_max_items, size_t threads_n, std::function<void()> on_thread_start);
     thread_pool(size_t q_max_items, size_t threads_n);
 
-    // message all threads to terminate gracefully join them
+    // shutdown() (if not called already) and report the messages it dropped (if any) to stderr
     ~thread_pool();
 
     // 不许拷贝构造和移动赋值
     thread_pool(const thread_pool &) = delete;
     thread_pool &operator=(thread_pool &&) = delete;
 
-    void post_log(async_logger_ptr &&worker_ptr, const details::log_msg &msg, async_overflow_policy overflow_policy);
-    void post_flush(async_logger_ptr &&worker_ptr, async_overflow_policy overflow_policy);
+    void post_log(async_logger *worker_ptr, const details::log_msg &msg, async_overflow_policy overflow_policy);
+    void post_deferred(async_logger *worker_ptr, const details::log_msg &msg, deferred_format_fn format_fn, size_t format_size,
+        async_overflow_policy overflow_policy);
+    // completion (if set) is completed after the logger's sinks were flushed
+    void post_flush(
+        async_logger *worker_ptr, async_overflow_policy overflow_policy, std::unique_ptr<flush_completion> completion = nullptr);
+    // the logger (registered as id) was destroyed - free its entry once its queued messages were processed.
+    // never blocks: if there is no room in the queue, the workers post the retire message once there is
+    // (see post_pending_retires_()). after shutdown() the entry is freed right away.
+    void post_retire(const async_logger *worker_ptr, uint64_t id);
+
+    // the table the async loggers of this pool are registered in (on their first post)
+    std::shared_ptr<logger_table> loggers() const;
     size_t overrun_counter();
+    size_t dropped_counter();
     size_t queue_size();
+    thread_pool_stats stats() const;
+
+    // call the callback with the stats every interval (from a dedicated thread).
+    // a zero interval stops the reporting.
+    void report_stats_every(std::chrono::seconds interval, std::function<void(const thread_pool_stats &)> callback);
+
+    // how the queued messages are handled by shutdown(). with async_shutdown_policy::drain_until
+    // the messages still queued after the timeout are dropped.
+    void set_shutdown_policy(async_shutdown_policy policy, std::chrono::milliseconds timeout = std::chrono::milliseconds::zero());
+
+    // process the queued messages (by the shutdown policy), then message all threads to terminate
+    // and join them. messages posted meanwhile or afterwards are dropped. with
+    // async_shutdown_policy::drain_until, workers still busy a timeout after that (e.g. in a
+    // stuck sink) are reported to stderr and left to the destructor, which detaches the ones
+    // still in a sink.
+    // Return the number of messages dropped by the shutdown
+    size_t shutdown();
+
+    // block until all the messages posted so far were processed by the workers.
+    // does nothing if called from one of the worker threads.
+    void wait_processed();
+
+    // visit the messages still in the queues, then the last batch each worker took, without
+    // blocking or allocating (for crash handlers). best effort - messages pushed/popped meanwhile
+    // may be torn, and a batch may have been written already.
+    void for_each_pending_unsafe(void (*fun)(const async_msg &msg, void *ctx), void *ctx);
+
+    // for_each_pending_unsafe(..) on every live pool. the pools publish themselves in a fixed
+    // table of atomics from construction to destruction, so no lock is taken and no pool is owned.
+    static void for_each_published_pending_unsafe(void (*fun)(const async_msg &msg, void *ctx), void *ctx);
+
+    // index of the calling worker thread (0 to threads_n-1), or -1 if not called from a worker thread.
+    // useful in on_thread_start to pin the workers to cpus (see os::set_thread_affinity()).
+    static size_t current_worker_index();
 
 private:
-    q_type q_; // 循环队列 带处理的数据
+    // single queue shared by all workers, or a queue per worker when sharded
+    std::vector<std::unique_ptr<async_queue<item_type>>> queues_; // 循环队列 带处理的数据
 
     std::vector<std::thread> threads_; // 处理数据的线程
 
-    void post_async_msg_(async_msg &&new_msg, async_overflow_policy overflow_policy);
-    void worker_loop_();
+    // shared with the async loggers, which may outlive the pool
+    std::shared_ptr<logger_table> loggers_;
+
+    // wait_processed() support. one barrier at a time, each worker must arrive at it.
+    std::mutex barrier_call_mutex_;
+    std::mutex barrier_mutex_;
+    std::condition_variable barrier_cv_;
+    size_t barrier_arrived_ = 0;
+    size_t barrier_generation_ = 0;
 
-    // process next message in the queue
+    static const size_t cacheline_size = 64;
+
+    // stats counters of a producer thread (see this_thread_counters_()). written by that
+    // thread only, so no cache line is shared with other producers and no read-modify-write
+    // is needed. stats() sums them.
+    struct producer_counters
+    {
+        std::atomic<size_t> enqueued{0};
+        std::atomic<size_t> overrun{0};
+        std::atomic<size_t> dropped{0};
+        std::atomic<std::chrono::nanoseconds::rep> blocked_ns{0};
+        std::atomic<bool> orphaned{false}; // the thread pool was destroyed
+        char pad_[cacheline_size];
+    };
+    const size_t id_; // tells the thread pools apart in the producers thread local counters
+    mutable std::mutex producers_mutex_;
+    std::vector<std::shared_ptr<producer_counters>> producers_;
+    // shared by the pool's own messages (which may be posted while thread locals are destroyed)
+    // and by all threads without thread local storage. added to with read-modify-write.
+    std::shared_ptr<producer_counters> shared_counters_;
+
+    // state of each worker, on its own cache line.
+    // batches - odd from before it pops a batch until it was processed. with workers sharing
+    // a queue, the entry of a retired logger is freed only once the other workers are done
+    // with the batches they had taken (its messages may be there).
+    // dequeued/max_depth - its stats counters. the queue depth is sampled by the workers.
+    // batch/batch_size - the messages it took last, for for_each_pending_unsafe().
+    struct worker_state
+    {
+        std::atomic<size_t> batches{0};
+        std::atomic<const async_msg *> batch{nullptr};
+        std::atomic<size_t> batch_size{0};
+        std::atomic<size_t> dequeued{0};
+        std::atomic<size_t> max_depth{0};
+        bool exited = false; // guarded by exit_mutex_
+        char pad_[cacheline_size];
+    };
+    std::unique_ptr<worker_state[]> worker_states_;
+
+    // shared by the pool and a worker, so the worker may outlive the pool.
+    // in_sink - the worker is in a call to a logger (format, sink or flush).
+    // abandoned - set by the destructor: the worker must exit. if it was in a sink, its thread
+    // was detached and it returns without touching the pool.
+    struct worker_guard
+    {
+        std::mutex mutex;
+        bool in_sink = false;
+        bool abandoned = false;
+    };
+    std::vector<std::shared_ptr<worker_guard>> worker_guards_;
+    std::mutex exit_mutex_;
+    std::condition_variable exit_cv_;
+
+    // shutdown state
+    std::mutex shutdown_mutex_;
+    async_shutdown_policy shutdown_policy_ = async_shutdown_policy::drain;
+    std::chrono::milliseconds shutdown_timeout_{0};
+    std::atomic<bool> draining_{false}; // no shutdown deadline - the workers take larger batches
+    std::atomic<bool> dropping_{false}; // the shutdown timeout passed - the workers drop the log messages
+    std::atomic<bool> stopped_{false};
+    std::atomic<bool> terminate_{false}; // the workers exit after their current batch
+    std::atomic<size_t> shutdown_dropped_{0};
+    std::atomic<size_t> shutdown_dequeued_{0}; // by shutdown() itself, left behind the terminate messages
+
+    // retire messages that found the queue full, posted by the workers after their batches.
+    // released by shutdown() once the workers are gone (finished_), like the later ones.
+    struct pending_retire
+    {
+        size_t queue_index;
+        async_msg msg;
+    };
+    std::mutex retires_mutex_;
+    std::vector<pending_retire> pending_retires_;
+    std::atomic<bool> retires_pending_{false};
+    bool finished_ = false; // guarded by retires_mutex_
+
+    std::mutex stats_reporter_mutex_;
+    std::unique_ptr<periodic_worker> stats_reporter_;
+
+    // max number of messages a worker pops from the queue at once
+    static const size_t batch_max_items = 64;
+    // while shutting down - to write the rest of the queue in bulk
+    static const size_t drain_batch_max_items = 1024;
+
+    // entry of a retired logger, and the batches of the other workers when its retire message was taken
+    struct pending_release
+    {
+        uint64_t logger_id;
+        std::vector<size_t> batches;
+    };
+
+    // buffers of a worker thread, reused for every batch
+    struct worker_context
+    {
+        size_t worker_index;
+        size_t queue_index;
+        std::vector<async_msg> batch;
+        std::vector<log_msg> run;
+        memory_buf_t scratch;
+        std::vector<pending_release> releases;
+        std::shared_ptr<worker_guard> guard;
+        bool abandoned = false; // the pool may be gone
+    };
+
+    static const size_t published_max = 16;
+    static std::atomic<thread_pool *> *published_();
+    void publish_();
+    void withdraw_();
+
+    static size_t &current_worker_index_();
+    static size_t next_pool_id_();
+    static wait_policy make_wait_policy_(async_wait_strategy wait_strategy);
+    size_t queue_index_(const async_logger *worker_ptr) const;
+    void post_async_msg_(size_t queue_index, async_msg &&new_msg, async_overflow_policy overflow_policy);
+    // never blocks. return false if the queue was full.
+    bool post_control_(size_t queue_index, async_msg &&new_msg);
+    // called by the workers after each batch, while retires_pending_
+    void post_pending_retires_();
+    // called by shutdown() - free the entries of the retires still pending
+    void release_pending_retires_();
+    void drop_left_messages_();
+    producer_counters &this_thread_counters_();
+    // add to a counter with a single writer
+    template<typename V>
+    static void add_(std::atomic<V> &counter, V n);
+    void worker_loop_(size_t worker_index);
+
+    // process next batch of messages in the queue
     // return true if this thread should still be active (while no terminate msg
     // was received)
-    bool process_next_msg_();
+    bool process_next_msg_(worker_context &ctx);
+    // around the calls to a logger. return false if the worker was abandoned (ctx.abandoned).
+    static bool enter_sink_(worker_context &ctx);
+    static bool leave_sink_(worker_context &ctx);
+
+    // called by a worker that popped a barrier message. wait for the other workers to arrive.
+    void arrive_at_barrier_();
+    // called by a worker that popped a retire message
+    void retire_logger_(worker_context &ctx, uint64_t logger_id);
+    // free the entries of ctx.releases the other workers are done with
+    void release_loggers_(worker_context &ctx);
+    bool is_worker_thread_() const;
 };
 
 } // namespace details
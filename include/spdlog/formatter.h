@@ -14,5 +14,13 @@ public:
     virtual ~formatter() = default;
     virtual void format(const details::log_msg &msg, memory_buf_t &dest) = 0;
     virtual std::unique_ptr<formatter> clone() const = 0;
+
+    // formatters of the same non zero id format every message the same way, so
+    // the sinks using them can share one formatted copy (see sinks::sink::formatter_id()).
+    // 0 - unknown.
+    virtual size_t format_id() const
+    {
+        return 0;
+    }
 };
 } // namespace spdlog
@@ -9,6 +9,8 @@
 
 #include <spdlog/sinks/sink.h>
 #include <spdlog/details/backtracer.h>
+#include <spdlog/details/callsite.h>
+#include <spdlog/details/sink_list.h>
 #include <spdlog/pattern_formatter.h>
 
 #include <cstdio>
@@ -24,6 +26,7 @@ SPDLOG_INLINE logger::logger(const logger &other)
     , flush_level_(other.flush_level_.load(std::memory_order_relaxed))
     , custom_err_handler_(other.custom_err_handler_)
     , tracer_(other.tracer_)
+    , deferred_formatting_(other.deferred_formatting_.load(std::memory_order_relaxed))
 {}
 
 SPDLOG_INLINE logger::logger(logger &&other) SPDLOG_NOEXCEPT : name_(std::move(other.name_)),
@@ -31,7 +34,8 @@ SPDLOG_INLINE logger::logger(logger &&other) SPDLOG_NOEXCEPT : name_(std::move(o
                                                                level_(other.level_.load(std::memory_order_relaxed)),
                                                                flush_level_(other.flush_level_.load(std::memory_order_relaxed)),
                                                                custom_err_handler_(std::move(other.custom_err_handler_)),
-                                                               tracer_(std::move(other.tracer_))
+                                                               tracer_(std::move(other.tracer_)),
+                                                               deferred_formatting_(other.deferred_formatting_.load(std::memory_order_relaxed))
 
 {}
 
@@ -58,6 +62,10 @@ SPDLOG_INLINE void logger::swap(spdlog::logger &other) SPDLOG_NOEXCEPT
 
     custom_err_handler_.swap(other.custom_err_handler_);
     std::swap(tracer_, other.tracer_);
+
+    auto other_deferred = other.deferred_formatting_.load();
+    other.deferred_formatting_.store(deferred_formatting_.exchange(other_deferred));
+    details::callsite::invalidate_all();
 }
 
 SPDLOG_INLINE void swap(logger &a, logger &b)
@@ -68,6 +76,7 @@ SPDLOG_INLINE void swap(logger &a, logger &b)
 SPDLOG_INLINE void logger::set_level(level::level_enum log_level)
 {
     level_.store(log_level);
+    details::callsite::invalidate_all();
 }
 
 SPDLOG_INLINE level::level_enum logger::level() const
@@ -84,9 +93,10 @@ SPDLOG_INLINE const std::string &logger::name() const
 // each sink will get a separate instance of the formatter object.
 SPDLOG_INLINE void logger::set_formatter(std::unique_ptr<formatter> f)
 {
-    for (auto it = sinks_.begin(); it != sinks_.end(); ++it)
+    details::sink_list::reader sinks(sinks_);
+    for (auto it = sinks.begin(); it != sinks.end(); ++it)
     {
-        if (std::next(it) == sinks_.end())
+        if (std::next(it) == sinks.end())
         {
             // last element - we can be move it.
             (*it)->set_formatter(std::move(f));
@@ -109,12 +119,14 @@ SPDLOG_INLINE void logger::set_pattern(std::string pattern, pattern_time_type ti
 SPDLOG_INLINE void logger::enable_backtrace(size_t n_messages)
 {
     tracer_.enable(n_messages);
+    details::callsite::invalidate_all();
 }
 
 // restore orig sinks and level and delete the backtrace sink
 SPDLOG_INLINE void logger::disable_backtrace()
 {
     tracer_.disable();
+    details::callsite::invalidate_all();
 }
 
 SPDLOG_INLINE void logger::dump_backtrace()
@@ -139,14 +151,29 @@ SPDLOG_INLINE level::level_enum logger::flush_level() const
 }
 
 // sinks
-SPDLOG_INLINE const std::vector<sink_ptr> &logger::sinks() const
+SPDLOG_INLINE void logger::add_sink(sink_ptr sink)
 {
-    return sinks_;
+    sinks_.add(std::move(sink));
 }
 
-SPDLOG_INLINE std::vector<sink_ptr> &logger::sinks()
+SPDLOG_INLINE void logger::remove_sink(const sink_ptr &sink)
 {
-    return sinks_;
+    sinks_.remove(sink);
+}
+
+SPDLOG_INLINE void logger::set_sinks(std::vector<sink_ptr> sinks)
+{
+    sinks_.set(std::move(sinks));
+}
+
+SPDLOG_INLINE std::vector<sink_ptr> logger::sinks() const
+{
+    return sinks_.copy();
+}
+
+SPDLOG_INLINE details::sink_list::editor logger::edit_sinks()
+{
+    return sinks_.edit();
 }
 
 // error handler
@@ -176,29 +203,145 @@ SPDLOG_INLINE void logger::log_it_(const spdlog::details::log_msg &log_msg, bool
     }
 }
 
+SPDLOG_INLINE void logger::append_suppressed_(memory_buf_t &buf, size_t suppressed)
+{
+    fmt::format_to(buf, " ({} similar messages suppressed)", suppressed);
+}
+
 SPDLOG_INLINE void logger::sink_it_(const details::log_msg &msg)
 {
-    for (auto &sink : sinks_)
+    details::sink_list::reader sinks(sinks_);
+    log_to_sinks_(sinks, msg);
+
+    if (should_flush_(msg))
     {
-        if (sink->should_log(msg.level))
+        flush_();
+    }
+}
+
+SPDLOG_INLINE void logger::sink_deferred_(const details::log_msg &msg, details::deferred_format_fn format_fn, size_t fmt_size)
+{
+    details::scratch_buffer scratch;
+    memory_buf_t &buf = scratch.get();
+    format_fn(string_view_t(msg.payload.data(), fmt_size), msg.payload.data() + fmt_size, buf);
+    details::log_msg formatted_msg(msg);
+    formatted_msg.payload = string_view_t(buf.data(), buf.size());
+    sink_it_(formatted_msg);
+}
+
+// sinks with the same formatter id produce the same output for a message,
+// so it is formatted once by the first of them and written by all.
+SPDLOG_INLINE void logger::log_to_sinks_(const details::sink_list::reader &sinks, const details::log_msg &msg)
+{
+    const size_t skip = static_cast<size_t>(-1);
+    size_t ids[max_shared_format_sinks];
+    size_t n = sinks.size();
+    bool shared = false;
+    if (n > 1 && n <= max_shared_format_sinks)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            const auto &sink = sinks.begin()[i];
+            ids[i] = sink->should_log(msg.level) ? sink->formatter_id() : skip;
+            for (size_t j = 0; j < i && !shared; j++)
+            {
+                shared = ids[i] != 0 && ids[i] != skip && ids[i] == ids[j];
+            }
+        }
+    }
+
+    if (!shared)
+    {
+        for (auto &sink : sinks)
         {
+            if (sink->should_log(msg.level))
+            {
+                SPDLOG_TRY
+                {
+                    sink->log(msg);
+                }
+                SPDLOG_LOGGER_CATCH()
+            }
+        }
+        return;
+    }
+
+    details::scratch_buffer scratch;
+    memory_buf_t &formatted = scratch.get();
+    for (size_t i = 0; i < n; i++)
+    {
+        if (ids[i] == skip)
+        {
+            continue;
+        }
+        const auto &sink = sinks.begin()[i];
+        size_t id = ids[i];
+        size_t j = i + 1;
+        while (id != 0 && j < n && ids[j] != id)
+        {
+            j++;
+        }
+        if (id == 0 || j == n)
+        {
+            // formats by itself (id 0), or not shared with the sinks that follow
             SPDLOG_TRY
             {
                 sink->log(msg);
             }
             SPDLOG_LOGGER_CATCH()
+            continue;
+        }
+
+        // the group leader formats and writes (under one lock), the others (marked done)
+        // write the same buffer
+        formatted.clear();
+        size_t format_id = 0;
+        SPDLOG_TRY
+        {
+            format_id = sink->format_and_log(msg, formatted);
+        }
+        SPDLOG_LOGGER_CATCH()
+        for (; j < n; j++)
+        {
+            if (ids[j] != id)
+            {
+                continue;
+            }
+            ids[j] = skip;
+            SPDLOG_TRY
+            {
+                sinks.begin()[j]->log_formatted(msg, formatted, format_id);
+            }
+            SPDLOG_LOGGER_CATCH()
         }
     }
+}
 
-    if (should_flush_(msg))
+SPDLOG_INLINE bool logger::sinks_share_format_(const details::sink_list::reader &sinks)
+{
+    size_t n = sinks.size();
+    if (n < 2 || n > max_shared_format_sinks)
     {
-        flush_();
+        return false;
+    }
+    size_t ids[max_shared_format_sinks];
+    for (size_t i = 0; i < n; i++)
+    {
+        ids[i] = sinks.begin()[i]->formatter_id();
+        for (size_t j = 0; j < i; j++)
+        {
+            if (ids[i] != 0 && ids[i] == ids[j])
+            {
+                return true;
+            }
+        }
     }
+    return false;
 }
 
 SPDLOG_INLINE void logger::flush_()
 {
-    for (auto &sink : sinks_)
+    for (auto &sink : details::sink_list::reader(sinks_))
     {
         SPDLOG_TRY
         {
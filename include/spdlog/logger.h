@@ -17,6 +17,9 @@
 #include <spdlog/common.h>
 #include <spdlog/details/log_msg.h>
 #include <spdlog/details/backtracer.h>
+#include <spdlog/details/deferred_format.h>
+#include <spdlog/details/scratch_buffer.h>
+#include <spdlog/details/sink_list.h>
 
 #ifdef SPDLOG_WCHAR_TO_UTF8_SUPPORT
 #include <spdlog/details/os.h>
@@ -201,6 +204,33 @@ public:
         log(source_loc{}, lvl, msg);
     }
 
+    // log, and note at the end of the message how many messages were suppressed before it
+    // (see the SPDLOG_<LEVEL>_EVERY_N and similar macros in spdlog.h).
+    // with structured fields the note is a "suppressed" field.
+    template<typename FormatString, typename Arg1, typename... Args>
+    void log_suppressed(size_t suppressed, source_loc loc, level::level_enum lvl, const FormatString &fmt, Arg1 &&arg1, Args &&...args)
+    {
+        if (suppressed == 0)
+        {
+            log(loc, lvl, fmt, std::forward<Arg1>(arg1), std::forward<Args>(args)...);
+            return;
+        }
+        log_suppressed_(
+            details::are_fields<Arg1, Args...>{}, suppressed, loc, lvl, fmt, std::forward<Arg1>(arg1), std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    void log_suppressed(size_t suppressed, source_loc loc, level::level_enum lvl, const T &msg)
+    {
+        if (suppressed == 0)
+        {
+            log(loc, lvl, msg);
+            return;
+        }
+        // through the log overloads, so wide messages are converted like any other
+        log(loc, lvl, suppressed_format_<T>(), msg, suppressed);
+    }
+
     // T cannot be statically converted to string_view or wstring_view
     template<class T, typename std::enable_if<!std::is_convertible<const T &, spdlog::string_view_t>::value &&
                                                   !is_convertible_to_wstring_view<const T &>::value,
@@ -266,7 +296,8 @@ public:
             fmt::wmemory_buffer wbuf;
             fmt::format_to(wbuf, fmt, std::forward<Args>(args)...);
 
-            memory_buf_t buf;
+            details::scratch_buffer scratch;
+            memory_buf_t &buf = scratch.get();
             details::os::wstr_to_utf8buf(wstring_view_t(wbuf.data(), wbuf.size()), buf);
             details::log_msg log_msg(loc, name_, lvl, string_view_t(buf.data(), buf.size()));
             log_it_(log_msg, log_enabled, traceback_enabled);
@@ -287,7 +318,8 @@ public:
 
         SPDLOG_TRY
         {
-            memory_buf_t buf;
+            details::scratch_buffer scratch;
+            memory_buf_t &buf = scratch.get();
             details::os::wstr_to_utf8buf(msg, buf);
             details::log_msg log_msg(loc, name_, lvl, string_view_t(buf.data(), buf.size()));
             log_it_(log_msg, log_enabled, traceback_enabled);
@@ -333,9 +365,18 @@ public:
     level::level_enum flush_level() const;
 
     // sinks
-    const std::vector<sink_ptr> &sinks() const;
-    std::vector<sink_ptr> &sinks();
-    // const 函数重载
+    // the sinks can be replaced while logging (without locking the logging threads).
+    // must not be called from one of the logger's sinks.
+    void add_sink(sink_ptr sink);
+    void remove_sink(const sink_ptr &sink);
+    void set_sinks(std::vector<sink_ptr> sinks);
+
+    // a copy of the current sinks
+    std::vector<sink_ptr> sinks() const;
+    // a copy to change in place, e.g. edit_sinks()->push_back(sink). it holds the lock of the
+    // above and replaces the sinks (if changed) when it goes away - keep it short lived, and do
+    // not call the above from the same thread meanwhile.
+    details::sink_list::editor edit_sinks();
 
     // error handler
     void set_error_handler(err_handler);
@@ -345,16 +386,51 @@ public:
 
 protected:
     std::string name_;
-    std::vector<sink_ptr> sinks_;
+    details::sink_list sinks_;
     spdlog::level_t level_{level::info};
     spdlog::level_t flush_level_{level::off};
     err_handler custom_err_handler_{nullptr}; // 异常函数
     details::backtracer tracer_;
+    std::atomic<bool> deferred_formatting_{false}; // set by async_logger
    
 
+    // formatting can be deferred only for runtime format strings with arithmetic args
+    template<typename FormatString, typename... Args>
+    using can_defer_ = std::integral_constant<bool,
+        std::is_same<FormatString, string_view_t>::value && details::deferred_args<typename std::decay<Args>::type...>::eligible>;
+
     // common implementation for after templated public api has been resolved
     template<typename FormatString, typename... Args>
     void log_(source_loc loc, level::level_enum lvl, const FormatString &fmt, Args&&...args)
+    {
+        log_(details::are_fields<Args...>{}, loc, lvl, fmt, std::forward<Args>(args)...);
+    }
+
+    // the message and its structured fields (logger.info("msg", kv("key", value)..)).
+    // the fields are not formatted here - the sinks get them typed in the log_msg.
+    template<typename FormatString, typename... Fields>
+    void log_(std::true_type, source_loc loc, level::level_enum lvl, const FormatString &msg, const Fields &...fields)
+    {
+        bool log_enabled = should_log(lvl);
+        bool traceback_enabled = tracer_.enabled();
+        if (!log_enabled && !traceback_enabled)
+        {
+            return;
+        }
+        SPDLOG_TRY
+        {
+            const field msg_fields[] = {fields...};
+            auto text = fmt::to_string_view(msg);
+            details::log_msg log_msg(loc, name_, lvl, string_view_t(text.data(), text.size()));
+            log_msg.fields = msg_fields;
+            log_msg.fields_n = sizeof...(Fields);
+            log_it_(log_msg, log_enabled, traceback_enabled);
+        }
+        SPDLOG_LOGGER_CATCH()
+    }
+
+    template<typename FormatString, typename... Args>
+    void log_(std::false_type, source_loc loc, level::level_enum lvl, const FormatString &fmt, Args&&...args)
     {
         bool log_enabled = should_log(lvl);
         bool traceback_enabled = tracer_.enabled();
@@ -364,7 +440,14 @@ protected:
         }
         SPDLOG_TRY
         {
-            memory_buf_t buf;
+            // the backtracer needs the formatted message, so never defer when it is enabled
+            if (!traceback_enabled && deferred_formatting_.load(std::memory_order_relaxed) &&
+                log_deferred_(can_defer_<FormatString, Args...>{}, loc, lvl, fmt, args...))
+            {
+                return;
+            }
+            details::scratch_buffer scratch;
+            memory_buf_t &buf = scratch.get();
             fmt::format_to(buf, fmt, std::forward<Args>(args)...);
             details::log_msg log_msg(loc, name_, lvl, string_view_t(buf.data(), buf.size()));
             log_it_(log_msg, log_enabled, traceback_enabled);
@@ -372,10 +455,82 @@ protected:
         SPDLOG_LOGGER_CATCH()
     }
 
+    // copy the format string and the raw args to the payload, and let
+    // sink_deferred_() format them.
+    template<typename... Args>
+    bool log_deferred_(std::true_type, source_loc loc, level::level_enum lvl, string_view_t fmt, const Args &... args)
+    {
+        using deferred = details::deferred_args<typename std::decay<Args>::type...>;
+        details::scratch_buffer scratch;
+        memory_buf_t &buf = scratch.get();
+        buf.append(fmt.data(), fmt.data() + fmt.size());
+        buf.resize(fmt.size() + deferred::size());
+        deferred::store(buf.data() + fmt.size(), args...);
+        details::log_msg log_msg(loc, name_, lvl, string_view_t(buf.data(), buf.size()));
+        sink_deferred_(log_msg, &deferred::format, fmt.size());
+        return true;
+    }
+
+    template<typename FormatString, typename... Args>
+    bool log_deferred_(std::false_type, source_loc, level::level_enum, const FormatString &, const Args &...)
+    {
+        return false;
+    }
+
     // log the given message (if the given log level is high enough),
     // and save backtrace (if backtrace is enabled).
     void log_it_(const details::log_msg &log_msg, bool log_enabled, bool traceback_enabled);
+    static void append_suppressed_(memory_buf_t &buf, size_t suppressed);
+    // format string for a message that is not itself a format string, wide if the message is
+    template<typename T, typename std::enable_if<!is_convertible_to_wstring_view<const T &>::value, int>::type = 0>
+    static string_view_t suppressed_format_()
+    {
+        return "{} ({} similar messages suppressed)";
+    }
+#ifdef SPDLOG_WCHAR_TO_UTF8_SUPPORT
+    template<typename T, typename std::enable_if<is_convertible_to_wstring_view<const T &>::value, int>::type = 0>
+    static wstring_view_t suppressed_format_()
+    {
+        return L"{} ({} similar messages suppressed)";
+    }
+#endif
+    template<typename FormatString, typename... Fields>
+    void log_suppressed_(
+        std::true_type, size_t suppressed, source_loc loc, level::level_enum lvl, const FormatString &msg, const Fields &...fields)
+    {
+        log_(std::true_type{}, loc, lvl, msg, fields..., kv("suppressed", suppressed));
+    }
+
+    template<typename FormatString, typename... Args>
+    void log_suppressed_(std::false_type, size_t suppressed, source_loc loc, level::level_enum lvl, const FormatString &fmt, Args &&...args)
+    {
+        bool log_enabled = should_log(lvl);
+        bool traceback_enabled = tracer_.enabled();
+        if (!log_enabled && !traceback_enabled)
+        {
+            return;
+        }
+        SPDLOG_TRY
+        {
+            details::scratch_buffer scratch;
+            memory_buf_t &buf = scratch.get();
+            fmt::format_to(buf, fmt, std::forward<Args>(args)...);
+            append_suppressed_(buf, suppressed);
+            details::log_msg log_msg(loc, name_, lvl, string_view_t(buf.data(), buf.size()));
+            log_it_(log_msg, log_enabled, traceback_enabled);
+        }
+        SPDLOG_LOGGER_CATCH()
+    }
     virtual void sink_it_(const details::log_msg &msg);
+    // log to each sink that should log the message. sinks with equivalent formatters share the formatting.
+    void log_to_sinks_(const details::sink_list::reader &sinks, const details::log_msg &msg);
+    // true if some of the sinks have equivalent formatters
+    static bool sinks_share_format_(const details::sink_list::reader &sinks);
+    // formatting is shared by up to this many sinks of a logger
+    static const size_t max_shared_format_sinks = 16;
+    // msg.payload holds the format string (of fmt_size bytes) followed by the raw args.
+    // default is to format them right away and call sink_it_().
+    virtual void sink_deferred_(const details::log_msg &msg, details::deferred_format_fn format_fn, size_t fmt_size);
     virtual void flush_();
     void dump_backtrace_();
     bool should_flush_(const details::log_msg &msg);
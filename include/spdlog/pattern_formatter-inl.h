@@ -7,6 +7,7 @@
 #include <spdlog/pattern_formatter.h>
 #endif
 
+#include <spdlog/details/civil_time.h>
 #include <spdlog/details/fmt_helper.h>
 #include <spdlog/details/log_msg.h>
 #include <spdlog/details/os.h>
@@ -103,168 +104,360 @@ struct null_scoped_padder
     }
 };
 
-template<typename ScopedPadder>
-class name_formatter final : public flag_formatter
+///////////////////////////////////////////////////////////////////////
+// Date time helpers
+///////////////////////////////////////////////////////////////////////
+
+static const char *ampm(const tm &t)
 {
-public:
-    explicit name_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
+    return t.tm_hour >= 12 ? "PM" : "AM";
+}
+
+static int to12h(const tm &t)
+{
+    return t.tm_hour > 12 ? t.tm_hour - 12 : t.tm_hour;
+}
+
+// Abbreviated weekday name
+static std::array<const char *, 7> days{{"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"}};
+
+// Full weekday name
+static std::array<const char *, 7> full_days{{"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"}};
+
+// Abbreviated month
+static const std::array<const char *, 12> months{{"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sept", "Oct", "Nov", "Dec"}};
+
+// Full month name
+static const std::array<const char *, 12> full_months{
+    {"January", "February", "March", "April", "May", "June", "July", "August", "September", "October", "November", "December"}};
 
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4127) // consider using 'if constexpr' instead
+#endif // _MSC_VER
+// source filename without the directory name
+static const char *short_filename(const char *filename)
+{
+    // if the size is 2 (1 character + null terminator) we can use the more efficient strrchr
+    // the branch will be elided by optimizations
+    if (sizeof(os::folder_seps) == 2)
     {
-        ScopedPadder p(msg.logger_name.size(), padinfo_, dest);
-        fmt_helper::append_string_view(msg.logger_name, dest);
+        const char *rv = std::strrchr(filename, os::folder_seps[0]);
+        return rv != nullptr ? rv + 1 : filename;
     }
-};
+    else
+    {
+        const std::reverse_iterator<const char *> begin(filename + std::strlen(filename));
+        const std::reverse_iterator<const char *> end(filename);
 
-// log level appender
-template<typename ScopedPadder>
-class level_formatter final : public flag_formatter
-{
-public:
-    explicit level_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
+        const auto it = std::find_first_of(begin, end, std::begin(os::folder_seps), std::end(os::folder_seps) - 1);
+        return it != end ? it.base() : filename;
+    }
+}
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif // _MSC_VER
 
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override
+// instructions that read the broken down time
+static bool uses_tm(pattern_op op)
+{
+    switch (op)
     {
-        const string_view_t &level_name = level::to_string_view(msg.level);
-        ScopedPadder p(level_name.size(), padinfo_, dest);
-        fmt_helper::append_string_view(level_name, dest);
+    case pattern_op::weekday:
+    case pattern_op::full_weekday:
+    case pattern_op::month:
+    case pattern_op::full_month:
+    case pattern_op::datetime:
+    case pattern_op::year2:
+    case pattern_op::year4:
+    case pattern_op::date_mdy:
+    case pattern_op::month_num:
+    case pattern_op::day:
+    case pattern_op::hour24:
+    case pattern_op::hour12:
+    case pattern_op::minute:
+    case pattern_op::second:
+    case pattern_op::ampm:
+    case pattern_op::time12:
+    case pattern_op::time_hm:
+    case pattern_op::time_hms:
+    case pattern_op::tz_offset:
+    case pattern_op::full:
+    case pattern_op::iso_datetime:
+    case pattern_op::custom:
+    case pattern_op::time_run:
+        return true;
+    default:
+        return false;
     }
-};
+}
 
-// short log level appender
-template<typename ScopedPadder>
-class short_level_formatter final : public flag_formatter
+// instructions whose output only changes once a second, or is a fixed size
+// sub-second field (patched into the cached output)
+static bool cacheable_per_second(const pattern_instr &instr)
 {
-public:
-    explicit short_level_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override
+    switch (instr.op)
     {
-        string_view_t level_name{level::to_short_c_str(msg.level)};
-        ScopedPadder p(level_name.size(), padinfo_, dest);
-        fmt_helper::append_string_view(level_name, dest);
+    case pattern_op::literal:
+    case pattern_op::epoch:
+        return true;
+    case pattern_op::millis:
+    case pattern_op::micros:
+    case pattern_op::nanos:
+        return !instr.padding.enabled();
+    case pattern_op::full:
+    case pattern_op::custom:
+    case pattern_op::time_run:
+        return false;
+    default:
+        return uses_tm(instr.op);
     }
-};
-
-///////////////////////////////////////////////////////////////////////
-// Date time pattern appenders
-///////////////////////////////////////////////////////////////////////
+}
 
-static const char *ampm(const tm &t)
+template<typename Units>
+static size_t elapsed_count(log_clock::duration delta)
 {
-    return t.tm_hour >= 12 ? "PM" : "AM";
+    return static_cast<size_t>(std::chrono::duration_cast<Units>(delta).count());
 }
 
-static int to12h(const tm &t)
+} // namespace details
+
+SPDLOG_INLINE pattern_formatter::pattern_formatter(
+    std::string pattern, pattern_time_type time_type, std::string eol, custom_flags custom_user_flags)
+    : pattern_(std::move(pattern))
+    , eol_(std::move(eol))
+    , pattern_time_type_(time_type)
+    , last_log_secs_(0)
+    , custom_handlers_(std::move(custom_user_flags))
 {
-    return t.tm_hour > 12 ? t.tm_hour - 12 : t.tm_hour;
+    std::memset(&cached_tm_, 0, sizeof(cached_tm_));
+    compile_pattern_(pattern_);
+    update_format_id_();
 }
 
-// Abbreviated weekday name
-static std::array<const char *, 7> days{{"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"}};
-
-template<typename ScopedPadder>
-class a_formatter final : public flag_formatter
+// use by default full formatter for if pattern is not given
+SPDLOG_INLINE pattern_formatter::pattern_formatter(pattern_time_type time_type, std::string eol)
+    : pattern_("%+")
+    , eol_(std::move(eol))
+    , pattern_time_type_(time_type)
+    , last_log_secs_(0)
 {
-public:
-    explicit a_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
+    std::memset(&cached_tm_, 0, sizeof(cached_tm_));
+    emit_(details::pattern_op::full, details::padding_info{});
+    update_format_id_();
+}
 
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override
+// the program is copied as is - no need to compile the pattern again.
+// the state of the instructions starts over, like in a new formatter.
+SPDLOG_INLINE pattern_formatter::pattern_formatter(const pattern_formatter &other, custom_flags custom_user_flags)
+    : pattern_(other.pattern_)
+    , eol_(other.eol_)
+    , pattern_time_type_(other.pattern_time_type_)
+    , last_log_secs_(0)
+    , custom_handlers_(std::move(custom_user_flags))
+    , format_id_(other.format_id_)
+    , program_(other.program_)
+    , literals_(other.literals_)
+    , time_caches_(other.time_caches_.size())
+    , needs_tm_(other.needs_tm_)
+    , elapsed_last_times_(other.elapsed_last_times_.size(), log_clock::now())
+{
+    std::memset(&cached_tm_, 0, sizeof(cached_tm_));
+    for (const auto &instr : program_)
     {
-        string_view_t field_value{days[static_cast<size_t>(tm_time.tm_wday)]};
-        ScopedPadder p(field_value.size(), padinfo_, dest);
-        fmt_helper::append_string_view(field_value, dest);
+        if (instr.op == details::pattern_op::custom)
+        {
+            custom_formatters_.push_back(other.custom_formatters_[instr.arg]->clone());
+            custom_formatters_.back()->set_padding_info(instr.padding);
+        }
     }
-};
+}
 
-// Full weekday name
-static std::array<const char *, 7> full_days{{"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"}};
+SPDLOG_INLINE std::unique_ptr<formatter> pattern_formatter::clone() const
+{
+    custom_flags cloned_custom_formatters;
+    for (auto &it : custom_handlers_)
+    {
+        cloned_custom_formatters[it.first] = it.second->clone();
+    }
+    return std::unique_ptr<formatter>(new pattern_formatter(*this, std::move(cloned_custom_formatters)));
+}
 
-template<typename ScopedPadder>
-class A_formatter : public flag_formatter
+SPDLOG_INLINE void pattern_formatter::format(const details::log_msg &msg, memory_buf_t &dest)
 {
-public:
-    explicit A_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
+    auto secs = std::chrono::duration_cast<std::chrono::seconds>(msg.time.time_since_epoch());
+    if (needs_tm_ && secs != last_log_secs_)
+    {
+        cached_tm_ = get_time_(msg);
+        last_log_secs_ = secs;
+        for (auto &cache : time_caches_)
+        {
+            cache.valid = false;
+        }
+    }
 
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override
+    for (size_t i = 0; i < program_.size(); i++)
     {
-        string_view_t field_value{full_days[static_cast<size_t>(tm_time.tm_wday)]};
-        ScopedPadder p(field_value.size(), padinfo_, dest);
-        fmt_helper::append_string_view(field_value, dest);
+        const auto &instr = program_[i];
+        if (instr.op == details::pattern_op::literal)
+        {
+            dest.append(literals_.data() + instr.arg, literals_.data() + instr.arg + instr.size);
+        }
+        else if (instr.op == details::pattern_op::time_run)
+        {
+            run_time_(instr, &program_[i + 1], msg, dest);
+            i += instr.size;
+        }
+        else if (instr.padding.enabled())
+        {
+            run_<details::scoped_padder>(instr, msg, dest);
+        }
+        else
+        {
+            run_<details::null_scoped_padder>(instr, msg, dest);
+        }
     }
-};
+    // write eol
+    details::fmt_helper::append_string_view(eol_, dest);
+}
 
-// Abbreviated month
-static const std::array<const char *, 12> months{{"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sept", "Oct", "Nov", "Dec"}};
+SPDLOG_INLINE size_t pattern_formatter::format_id() const
+{
+    return format_id_;
+}
 
-template<typename ScopedPadder>
-class b_formatter final : public flag_formatter
+SPDLOG_INLINE void pattern_formatter::set_pattern(std::string pattern)
 {
-public:
-    explicit b_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
+    pattern_ = std::move(pattern);
+    compile_pattern_(pattern_);
+    update_format_id_();
+}
+
+// the ids are handed out per distinct (pattern, time type, eol), so equal ids never collide.
+// the elapsed flags print the time since the formatter's own last message - never shared.
+SPDLOG_INLINE void pattern_formatter::update_format_id_()
+{
+    bool has_elapsed = std::any_of(program_.begin(), program_.end(),
+        [](const details::pattern_instr &instr) { return instr.op == details::pattern_op::elapsed; });
+    format_id_ = custom_handlers_.empty() && !has_elapsed ? format_id_of(pattern_, pattern_time_type_, eol_) : 0;
+}
 
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override
+SPDLOG_INLINE size_t pattern_formatter::format_id_of(const std::string &pattern, pattern_time_type time_type, const std::string &eol)
+{
+    static std::mutex ids_mutex;
+    static std::unordered_map<std::string, size_t> ids;
+    std::string key = pattern;
+    key.push_back('\0');
+    key.push_back(time_type == pattern_time_type::local ? 'l' : 'u');
+    key += eol;
+
+    std::lock_guard<std::mutex> lock(ids_mutex);
+    auto it = ids.find(key);
+    if (it == ids.end())
     {
-        string_view_t field_value{months[static_cast<size_t>(tm_time.tm_mon)]};
-        ScopedPadder p(field_value.size(), padinfo_, dest);
-        fmt_helper::append_string_view(field_value, dest);
+        it = ids.emplace(std::move(key), ids.size() + 1).first;
     }
-};
+    return it->second;
+}
 
-// Full month name
-static const std::array<const char *, 12> full_months{
-    {"January", "February", "March", "April", "May", "June", "July", "August", "September", "October", "November", "December"}};
+SPDLOG_INLINE std::tm pattern_formatter::get_time_(const details::log_msg &msg)
+{
+    if (pattern_time_type_ == pattern_time_type::local)
+    {
+        return details::civil_time::local(log_clock::to_time_t(msg.time));
+    }
+    return details::civil_time::utc(log_clock::to_time_t(msg.time));
+}
 
+// run a flag instruction. the padding of the field is applied by the ScopedPadder.
 template<typename ScopedPadder>
-class B_formatter final : public flag_formatter
+SPDLOG_INLINE void pattern_formatter::run_(const details::pattern_instr &instr, const details::log_msg &msg, memory_buf_t &dest)
 {
-public:
-    explicit B_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
+    using details::pattern_op;
+    namespace fmt_helper = details::fmt_helper;
+    const details::padding_info &padinfo = instr.padding;
+    const std::tm &tm_time = cached_tm_;
 
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override
+    switch (instr.op)
     {
-        string_view_t field_value{full_months[static_cast<size_t>(tm_time.tm_mon)]};
-        ScopedPadder p(field_value.size(), padinfo_, dest);
+    case pattern_op::literal:
+        dest.append(literals_.data() + instr.arg, literals_.data() + instr.arg + instr.size);
+        break;
+
+    case pattern_op::name: {
+        ScopedPadder p(msg.logger_name.size(), padinfo, dest);
+        fmt_helper::append_string_view(msg.logger_name, dest);
+        break;
+    }
+
+    case pattern_op::level: {
+        const string_view_t &level_name = level::to_string_view(msg.level);
+        ScopedPadder p(level_name.size(), padinfo, dest);
+        fmt_helper::append_string_view(level_name, dest);
+        break;
+    }
+
+    case pattern_op::short_level: {
+        string_view_t level_name{level::to_short_c_str(msg.level)};
+        ScopedPadder p(level_name.size(), padinfo, dest);
+        fmt_helper::append_string_view(level_name, dest);
+        break;
+    }
+
+    case pattern_op::thread_id: {
+        const auto field_size = ScopedPadder::count_digits(msg.thread_id);
+        ScopedPadder p(field_size, padinfo, dest);
+        fmt_helper::append_int(msg.thread_id, dest);
+        break;
+    }
+
+    case pattern_op::payload: {
+        {
+            ScopedPadder p(msg.payload.size(), padinfo, dest);
+            fmt_helper::append_string_view(msg.payload, dest);
+        }
+        // the fields are serialized only for sinks that want the text
+        fmt_helper::append_fields(msg.fields, msg.fields_n, dest);
+        break;
+    }
+
+    case pattern_op::weekday: {
+        string_view_t field_value{details::days[static_cast<size_t>(tm_time.tm_wday)]};
+        ScopedPadder p(field_value.size(), padinfo, dest);
         fmt_helper::append_string_view(field_value, dest);
+        break;
     }
-};
 
-// Date and time representation (Thu Aug 23 15:35:46 2014)
-template<typename ScopedPadder>
-class c_formatter final : public flag_formatter
-{
-public:
-    explicit c_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
+    case pattern_op::full_weekday: {
+        string_view_t field_value{details::full_days[static_cast<size_t>(tm_time.tm_wday)]};
+        ScopedPadder p(field_value.size(), padinfo, dest);
+        fmt_helper::append_string_view(field_value, dest);
+        break;
+    }
 
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override
-    {
-        const size_t field_size = 24;
-        ScopedPadder p(field_size, padinfo_, dest);
+    case pattern_op::month: {
+        string_view_t field_value{details::months[static_cast<size_t>(tm_time.tm_mon)]};
+        ScopedPadder p(field_value.size(), padinfo, dest);
+        fmt_helper::append_string_view(field_value, dest);
+        break;
+    }
+
+    case pattern_op::full_month: {
+        string_view_t field_value{details::full_months[static_cast<size_t>(tm_time.tm_mon)]};
+        ScopedPadder p(field_value.size(), padinfo, dest);
+        fmt_helper::append_string_view(field_value, dest);
+        break;
+    }
 
-        fmt_helper::append_string_view(days[static_cast<size_t>(tm_time.tm_wday)], dest);
+    case pattern_op::datetime: { // Thu Aug 23 15:35:46 2014
+        const size_t field_size = 24;
+        ScopedPadder p(field_size, padinfo, dest);
+        fmt_helper::append_string_view(details::days[static_cast<size_t>(tm_time.tm_wday)], dest);
         dest.push_back(' ');
-        fmt_helper::append_string_view(months[static_cast<size_t>(tm_time.tm_mon)], dest);
+        fmt_helper::append_string_view(details::months[static_cast<size_t>(tm_time.tm_mon)], dest);
         dest.push_back(' ');
         fmt_helper::append_int(tm_time.tm_mday, dest);
         dest.push_back(' ');
-        // time
-
         fmt_helper::pad2(tm_time.tm_hour, dest);
         dest.push_back(':');
         fmt_helper::pad2(tm_time.tm_min, dest);
@@ -272,823 +465,494 @@ public:
         fmt_helper::pad2(tm_time.tm_sec, dest);
         dest.push_back(' ');
         fmt_helper::append_int(tm_time.tm_year + 1900, dest);
+        break;
     }
-};
 
-// year - 2 digit
-template<typename ScopedPadder>
-class C_formatter final : public flag_formatter
-{
-public:
-    explicit C_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override
-    {
-        const size_t field_size = 2;
-        ScopedPadder p(field_size, padinfo_, dest);
+    case pattern_op::year2: {
+        ScopedPadder p(2, padinfo, dest);
         fmt_helper::pad2(tm_time.tm_year % 100, dest);
+        break;
     }
-};
-
-// Short MM/DD/YY date, equivalent to %m/%d/%y 08/23/01
-template<typename ScopedPadder>
-class D_formatter final : public flag_formatter
-{
-public:
-    explicit D_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
 
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override
-    {
-        const size_t field_size = 10;
-        ScopedPadder p(field_size, padinfo_, dest);
+    case pattern_op::year4: {
+        ScopedPadder p(4, padinfo, dest);
+        fmt_helper::append_int(tm_time.tm_year + 1900, dest);
+        break;
+    }
 
+    case pattern_op::date_mdy: { // 08/23/01
+        ScopedPadder p(10, padinfo, dest);
         fmt_helper::pad2(tm_time.tm_mon + 1, dest);
         dest.push_back('/');
         fmt_helper::pad2(tm_time.tm_mday, dest);
         dest.push_back('/');
         fmt_helper::pad2(tm_time.tm_year % 100, dest);
+        break;
     }
-};
-
-// year - 4 digit
-template<typename ScopedPadder>
-class Y_formatter final : public flag_formatter
-{
-public:
-    explicit Y_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override
-    {
-        const size_t field_size = 4;
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::append_int(tm_time.tm_year + 1900, dest);
-    }
-};
 
-// month 1-12
-template<typename ScopedPadder>
-class m_formatter final : public flag_formatter
-{
-public:
-    explicit m_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override
-    {
-        const size_t field_size = 2;
-        ScopedPadder p(field_size, padinfo_, dest);
+    case pattern_op::month_num: {
+        ScopedPadder p(2, padinfo, dest);
         fmt_helper::pad2(tm_time.tm_mon + 1, dest);
+        break;
     }
-};
 
-// day of month 1-31
-template<typename ScopedPadder>
-class d_formatter final : public flag_formatter
-{
-public:
-    explicit d_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override
-    {
-        const size_t field_size = 2;
-        ScopedPadder p(field_size, padinfo_, dest);
+    case pattern_op::day: {
+        ScopedPadder p(2, padinfo, dest);
         fmt_helper::pad2(tm_time.tm_mday, dest);
+        break;
     }
-};
-
-// hours in 24 format 0-23
-template<typename ScopedPadder>
-class H_formatter final : public flag_formatter
-{
-public:
-    explicit H_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
 
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override
-    {
-        const size_t field_size = 2;
-        ScopedPadder p(field_size, padinfo_, dest);
+    case pattern_op::hour24: {
+        ScopedPadder p(2, padinfo, dest);
         fmt_helper::pad2(tm_time.tm_hour, dest);
+        break;
     }
-};
 
-// hours in 12 format 1-12
-template<typename ScopedPadder>
-class I_formatter final : public flag_formatter
-{
-public:
-    explicit I_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override
-    {
-        const size_t field_size = 2;
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::pad2(to12h(tm_time), dest);
+    case pattern_op::hour12: {
+        ScopedPadder p(2, padinfo, dest);
+        fmt_helper::pad2(details::to12h(tm_time), dest);
+        break;
     }
-};
 
-// minutes 0-59
-template<typename ScopedPadder>
-class M_formatter final : public flag_formatter
-{
-public:
-    explicit M_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override
-    {
-        const size_t field_size = 2;
-        ScopedPadder p(field_size, padinfo_, dest);
+    case pattern_op::minute: {
+        ScopedPadder p(2, padinfo, dest);
         fmt_helper::pad2(tm_time.tm_min, dest);
+        break;
     }
-};
-
-// seconds 0-59
-template<typename ScopedPadder>
-class S_formatter final : public flag_formatter
-{
-public:
-    explicit S_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
 
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override
-    {
-        const size_t field_size = 2;
-        ScopedPadder p(field_size, padinfo_, dest);
+    case pattern_op::second: {
+        ScopedPadder p(2, padinfo, dest);
         fmt_helper::pad2(tm_time.tm_sec, dest);
+        break;
     }
-};
-
-// milliseconds
-template<typename ScopedPadder>
-class e_formatter final : public flag_formatter
-{
-public:
-    explicit e_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
 
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override
-    {
+    case pattern_op::millis: {
         auto millis = fmt_helper::time_fraction<std::chrono::milliseconds>(msg.time);
-        const size_t field_size = 3;
-        ScopedPadder p(field_size, padinfo_, dest);
+        ScopedPadder p(3, padinfo, dest);
         fmt_helper::pad3(static_cast<uint32_t>(millis.count()), dest);
+        break;
     }
-};
-
-// microseconds
-template<typename ScopedPadder>
-class f_formatter final : public flag_formatter
-{
-public:
-    explicit f_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
 
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override
-    {
+    case pattern_op::micros: {
         auto micros = fmt_helper::time_fraction<std::chrono::microseconds>(msg.time);
-
-        const size_t field_size = 6;
-        ScopedPadder p(field_size, padinfo_, dest);
+        ScopedPadder p(6, padinfo, dest);
         fmt_helper::pad6(static_cast<size_t>(micros.count()), dest);
+        break;
     }
-};
 
-// nanoseconds
-template<typename ScopedPadder>
-class F_formatter final : public flag_formatter
-{
-public:
-    explicit F_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override
-    {
+    case pattern_op::nanos: {
         auto ns = fmt_helper::time_fraction<std::chrono::nanoseconds>(msg.time);
-        const size_t field_size = 9;
-        ScopedPadder p(field_size, padinfo_, dest);
+        ScopedPadder p(9, padinfo, dest);
         fmt_helper::pad9(static_cast<size_t>(ns.count()), dest);
+        break;
     }
-};
-
-// seconds since epoch
-template<typename ScopedPadder>
-class E_formatter final : public flag_formatter
-{
-public:
-    explicit E_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
 
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override
-    {
-        const size_t field_size = 10;
-        ScopedPadder p(field_size, padinfo_, dest);
-        auto duration = msg.time.time_since_epoch();
-        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(duration).count();
+    case pattern_op::epoch: {
+        ScopedPadder p(10, padinfo, dest);
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(msg.time.time_since_epoch()).count();
         fmt_helper::append_int(seconds, dest);
+        break;
     }
-};
 
-// AM/PM
-template<typename ScopedPadder>
-class p_formatter final : public flag_formatter
-{
-public:
-    explicit p_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override
-    {
-        const size_t field_size = 2;
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::append_string_view(ampm(tm_time), dest);
+    case pattern_op::ampm: {
+        ScopedPadder p(2, padinfo, dest);
+        fmt_helper::append_string_view(details::ampm(tm_time), dest);
+        break;
     }
-};
-
-// 12 hour clock 02:55:02 pm
-template<typename ScopedPadder>
-class r_formatter final : public flag_formatter
-{
-public:
-    explicit r_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override
-    {
-        const size_t field_size = 11;
-        ScopedPadder p(field_size, padinfo_, dest);
 
-        fmt_helper::pad2(to12h(tm_time), dest);
+    case pattern_op::time12: { // 02:55:02 PM
+        ScopedPadder p(11, padinfo, dest);
+        fmt_helper::pad2(details::to12h(tm_time), dest);
         dest.push_back(':');
         fmt_helper::pad2(tm_time.tm_min, dest);
         dest.push_back(':');
         fmt_helper::pad2(tm_time.tm_sec, dest);
         dest.push_back(' ');
-        fmt_helper::append_string_view(ampm(tm_time), dest);
+        fmt_helper::append_string_view(details::ampm(tm_time), dest);
+        break;
     }
-};
-
-// 24-hour HH:MM time, equivalent to %H:%M
-template<typename ScopedPadder>
-class R_formatter final : public flag_formatter
-{
-public:
-    explicit R_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override
-    {
-        const size_t field_size = 5;
-        ScopedPadder p(field_size, padinfo_, dest);
 
+    case pattern_op::time_hm: {
+        ScopedPadder p(5, padinfo, dest);
         fmt_helper::pad2(tm_time.tm_hour, dest);
         dest.push_back(':');
         fmt_helper::pad2(tm_time.tm_min, dest);
+        break;
     }
-};
-
-// ISO 8601 time format (HH:MM:SS), equivalent to %H:%M:%S
-template<typename ScopedPadder>
-class T_formatter final : public flag_formatter
-{
-public:
-    explicit T_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
-
-    void format(const details::log_msg &, const std::tm &tm_time, memory_buf_t &dest) override
-    {
-        const size_t field_size = 8;
-        ScopedPadder p(field_size, padinfo_, dest);
 
+    case pattern_op::time_hms: {
+        ScopedPadder p(8, padinfo, dest);
         fmt_helper::pad2(tm_time.tm_hour, dest);
         dest.push_back(':');
         fmt_helper::pad2(tm_time.tm_min, dest);
         dest.push_back(':');
         fmt_helper::pad2(tm_time.tm_sec, dest);
+        break;
     }
-};
-
-// ISO 8601 offset from UTC in timezone (+-HH:MM)
-template<typename ScopedPadder>
-class z_formatter final : public flag_formatter
-{
-public:
-    explicit z_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
-
-    z_formatter() = default;
-    z_formatter(const z_formatter &) = delete;
-    z_formatter &operator=(const z_formatter &) = delete;
-
-    void format(const details::log_msg &msg, const std::tm &tm_time, memory_buf_t &dest) override
-    {
-        const size_t field_size = 6;
-        ScopedPadder p(field_size, padinfo_, dest);
 
-        auto total_minutes = get_cached_offset(msg, tm_time);
-        bool is_negative = total_minutes < 0;
-        if (is_negative)
+    case pattern_op::tz_offset: { // +-HH:MM
+        ScopedPadder p(6, padinfo, dest);
+        // the zone offset is cached with the local time conversion
+        auto total_minutes = pattern_time_type_ == pattern_time_type::local
+                                 ? details::civil_time::utc_minutes_offset(log_clock::to_time_t(msg.time))
+                                 : 0;
+        if (total_minutes < 0)
         {
             total_minutes = -total_minutes;
             dest.push_back('-');
         }
-        else
-        {
-            dest.push_back('+');
-        }
-
-        fmt_helper::pad2(total_minutes / 60, dest); // hours
-        dest.push_back(':');
-        fmt_helper::pad2(total_minutes % 60, dest); // minutes
-    }
-
-private:
-    log_clock::time_point last_update_{std::chrono::seconds(0)};
-    int offset_minutes_{0};
-
-    int get_cached_offset(const log_msg &msg, const std::tm &tm_time)
-    {
-        // refresh every 10 seconds
-        if (msg.time - last_update_ >= std::chrono::seconds(10))
-        {
-            offset_minutes_ = os::utc_minutes_offset(tm_time);
-            last_update_ = msg.time;
-        }
-        return offset_minutes_;
-    }
-};
-
-// Thread id
-template<typename ScopedPadder>
-class t_formatter final : public flag_formatter
-{
-public:
-    explicit t_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override
-    {
-        const auto field_size = ScopedPadder::count_digits(msg.thread_id);
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::append_int(msg.thread_id, dest);
-    }
-};
-
-// Current pid
-template<typename ScopedPadder>
-class pid_formatter final : public flag_formatter
-{
-public:
-    explicit pid_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
-
-    void format(const details::log_msg &, const std::tm &, memory_buf_t &dest) override
-    {
-        const auto pid = static_cast<uint32_t>(details::os::pid());
-        auto field_size = ScopedPadder::count_digits(pid);
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::append_int(pid, dest);
-    }
-};
-
-template<typename ScopedPadder>
-class v_formatter final : public flag_formatter
-{
-public:
-    explicit v_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override
-    {
-        ScopedPadder p(msg.payload.size(), padinfo_, dest);
-        fmt_helper::append_string_view(msg.payload, dest);
-    }
-};
-
-class ch_formatter final : public flag_formatter
-{
-public:
-    explicit ch_formatter(char ch)
-        : ch_(ch)
-    {}
-
-    void format(const details::log_msg &, const std::tm &, memory_buf_t &dest) override
-    {
-        dest.push_back(ch_);
-    }
-
-private:
-    char ch_;
-};
-
-// aggregate user chars to display as is
-class aggregate_formatter final : public flag_formatter
-{
-public:
-    aggregate_formatter() = default;
-
-    void add_ch(char ch)
-    {
-        str_ += ch;
-    }
-    void format(const details::log_msg &, const std::tm &, memory_buf_t &dest) override
-    {
-        fmt_helper::append_string_view(str_, dest);
+        else
+        {
+            dest.push_back('+');
+        }
+        fmt_helper::pad2(total_minutes / 60, dest); // hours
+        dest.push_back(':');
+        fmt_helper::pad2(total_minutes % 60, dest); // minutes
+        break;
     }
 
-private:
-    std::string str_;
-};
-
-// mark the color range. expect it to be in the form of "%^colored text%$"
-class color_start_formatter final : public flag_formatter
-{
-public:
-    explicit color_start_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override
-    {
-        msg.color_range_start = dest.size();
+    case pattern_op::pid: {
+        const auto pid = static_cast<uint32_t>(details::os::pid());
+        auto field_size = ScopedPadder::count_digits(pid);
+        ScopedPadder p(field_size, padinfo, dest);
+        fmt_helper::append_int(pid, dest);
+        break;
     }
-};
 
-class color_stop_formatter final : public flag_formatter
-{
-public:
-    explicit color_stop_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
+    // mark the color range. expect it to be in the form of "%^colored text%$"
+    case pattern_op::color_start:
+        msg.color_range_start = dest.size();
+        break;
 
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override
-    {
+    case pattern_op::color_stop:
         msg.color_range_end = dest.size();
-    }
-};
-
-// print source location
-template<typename ScopedPadder>
-class source_location_formatter final : public flag_formatter
-{
-public:
-    explicit source_location_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
+        break;
 
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override
-    {
+    case pattern_op::source_loc: {
         if (msg.source.empty())
         {
-            return;
-        }
-
-        size_t text_size;
-        if (padinfo_.enabled())
-        {
-            // calc text size for padding based on "filename:line"
-            text_size = std::char_traits<char>::length(msg.source.filename) + ScopedPadder::count_digits(msg.source.line) + 1;
-        }
-        else
-        {
-            text_size = 0;
+            break;
         }
-
-        ScopedPadder p(text_size, padinfo_, dest);
+        // calc text size for padding based on "filename:line"
+        size_t text_size =
+            padinfo.enabled() ? std::char_traits<char>::length(msg.source.filename) + ScopedPadder::count_digits(msg.source.line) + 1 : 0;
+        ScopedPadder p(text_size, padinfo, dest);
         fmt_helper::append_string_view(msg.source.filename, dest);
         dest.push_back(':');
         fmt_helper::append_int(msg.source.line, dest);
+        break;
     }
-};
 
-// print source filename
-template<typename ScopedPadder>
-class source_filename_formatter final : public flag_formatter
-{
-public:
-    explicit source_filename_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
+    case pattern_op::short_filename: {
+        if (msg.source.empty())
+        {
+            break;
+        }
+        auto filename = details::short_filename(msg.source.filename);
+        size_t text_size = padinfo.enabled() ? std::char_traits<char>::length(filename) : 0;
+        ScopedPadder p(text_size, padinfo, dest);
+        fmt_helper::append_string_view(filename, dest);
+        break;
+    }
 
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override
-    {
+    case pattern_op::filename: {
         if (msg.source.empty())
         {
-            return;
+            break;
         }
-        size_t text_size = padinfo_.enabled() ? std::char_traits<char>::length(msg.source.filename) : 0;
-        ScopedPadder p(text_size, padinfo_, dest);
+        size_t text_size = padinfo.enabled() ? std::char_traits<char>::length(msg.source.filename) : 0;
+        ScopedPadder p(text_size, padinfo, dest);
         fmt_helper::append_string_view(msg.source.filename, dest);
+        break;
     }
-};
-
-template<typename ScopedPadder>
-class short_filename_formatter final : public flag_formatter
-{
-public:
-    explicit short_filename_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
 
-#ifdef _MSC_VER
-#pragma warning(push)
-#pragma warning(disable : 4127) // consider using 'if constexpr' instead
-#endif // _MSC_VER
-    static const char *basename(const char *filename)
-    {
-        // if the size is 2 (1 character + null terminator) we can use the more efficient strrchr
-        // the branch will be elided by optimizations
-        if (sizeof(os::folder_seps) == 2)
+    case pattern_op::line: {
+        if (msg.source.empty())
         {
-            const char *rv = std::strrchr(filename, os::folder_seps[0]);
-            return rv != nullptr ? rv + 1 : filename;
+            break;
         }
-        else
-        {
-            const std::reverse_iterator<const char*> begin(filename + std::strlen(filename));
-            const std::reverse_iterator<const char*> end(filename);
+        auto field_size = ScopedPadder::count_digits(msg.source.line);
+        ScopedPadder p(field_size, padinfo, dest);
+        fmt_helper::append_int(msg.source.line, dest);
+        break;
+    }
 
-            const auto it = std::find_first_of(begin, end, std::begin(os::folder_seps), std::end(os::folder_seps) - 1);
-            return it != end ? it.base() : filename;
+    case pattern_op::funcname: {
+        if (msg.source.empty())
+        {
+            break;
         }
+        size_t text_size = padinfo.enabled() ? std::char_traits<char>::length(msg.source.funcname) : 0;
+        ScopedPadder p(text_size, padinfo, dest);
+        fmt_helper::append_string_view(msg.source.funcname, dest);
+        break;
     }
-#ifdef _MSC_VER
-#pragma warning(pop)
-#endif // _MSC_VER
 
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override
-    {
-        if (msg.source.empty())
+    case pattern_op::elapsed: { // since the last message
+        auto &last_time = elapsed_last_times_[instr.arg];
+        auto delta = (std::max)(msg.time - last_time, log_clock::duration::zero());
+        last_time = msg.time;
+        size_t delta_count;
+        switch (static_cast<details::elapsed_units>(instr.size))
         {
-            return;
+        case details::elapsed_units::nanos:
+            delta_count = details::elapsed_count<std::chrono::nanoseconds>(delta);
+            break;
+        case details::elapsed_units::micros:
+            delta_count = details::elapsed_count<std::chrono::microseconds>(delta);
+            break;
+        case details::elapsed_units::millis:
+            delta_count = details::elapsed_count<std::chrono::milliseconds>(delta);
+            break;
+        default:
+            delta_count = details::elapsed_count<std::chrono::seconds>(delta);
+            break;
         }
-        auto filename = basename(msg.source.filename);
-        size_t text_size = padinfo_.enabled() ? std::char_traits<char>::length(filename) : 0;
-        ScopedPadder p(text_size, padinfo_, dest);
-        fmt_helper::append_string_view(filename, dest);
+        auto n_digits = static_cast<size_t>(ScopedPadder::count_digits(delta_count));
+        ScopedPadder p(n_digits, padinfo, dest);
+        fmt_helper::append_int(delta_count, dest);
+        break;
     }
-};
 
-template<typename ScopedPadder>
-class source_linenum_formatter final : public flag_formatter
-{
-public:
-    explicit source_linenum_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
+    case pattern_op::full:
+        run_full_(msg, dest);
+        break;
 
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override
-    {
-        if (msg.source.empty())
+    case pattern_op::iso_datetime: {
+        auto year = tm_time.tm_year + 1900;
+        auto nanos = fmt_helper::time_fraction<std::chrono::nanoseconds>(msg.time).count();
+        if (year >= 0 && year <= 9999 && nanos >= 0)
         {
-            return;
+            char buf[fmt_helper::datetime_buf_size];
+            fmt_helper::write_datetime(tm_time, static_cast<uint32_t>(nanos), buf);
+            dest.append(buf, buf + instr.size);
+            break;
+        }
+        // out of the range of write_datetime() - field by field
+        fmt_helper::append_int(year, dest);
+        dest.push_back('-');
+        fmt_helper::pad2(tm_time.tm_mon + 1, dest);
+        dest.push_back('-');
+        fmt_helper::pad2(tm_time.tm_mday, dest);
+        dest.push_back(' ');
+        fmt_helper::pad2(tm_time.tm_hour, dest);
+        dest.push_back(':');
+        fmt_helper::pad2(tm_time.tm_min, dest);
+        dest.push_back(':');
+        fmt_helper::pad2(tm_time.tm_sec, dest);
+        if (instr.size == 19)
+        {
+            break;
+        }
+        dest.push_back('.');
+        if (instr.size == 23)
+        {
+            fmt_helper::pad3(static_cast<uint32_t>(fmt_helper::time_fraction<std::chrono::milliseconds>(msg.time).count()), dest);
+        }
+        else if (instr.size == 26)
+        {
+            fmt_helper::pad6(static_cast<size_t>(fmt_helper::time_fraction<std::chrono::microseconds>(msg.time).count()), dest);
+        }
+        else
+        {
+            fmt_helper::pad9(static_cast<size_t>(nanos), dest);
         }
+        break;
+    }
 
-        auto field_size = ScopedPadder::count_digits(msg.source.line);
-        ScopedPadder p(field_size, padinfo_, dest);
-        fmt_helper::append_int(msg.source.line, dest);
+    case pattern_op::custom:
+        custom_formatters_[instr.arg]->format(msg, tm_time, dest);
+        break;
+
+    case pattern_op::time_run: // run by format()
+        break;
     }
-};
+}
 
-// print source funcname
-template<typename ScopedPadder>
-class source_funcname_formatter final : public flag_formatter
+// render the instructions of the run, or copy them from the cache if already rendered
+// in this second. the sub-second fields are patched into the copy.
+SPDLOG_INLINE void pattern_formatter::run_time_(
+    const details::pattern_instr &run, const details::pattern_instr *instrs, const details::log_msg &msg, memory_buf_t &dest)
 {
-public:
-    explicit source_funcname_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
+    using details::pattern_op;
+    namespace fmt_helper = details::fmt_helper;
+    auto &cache = time_caches_[run.arg];
+    auto start = dest.size();
 
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override
+    if (cache.valid)
     {
-        if (msg.source.empty())
+        dest.append(cache.bytes.data(), cache.bytes.data() + cache.bytes.size());
+        char *out = dest.data() + start;
+        for (const auto &patch : cache.patches)
         {
-            return;
+            switch (patch.op)
+            {
+            case pattern_op::millis:
+                fmt_helper::write_padded(
+                    static_cast<uint32_t>(fmt_helper::time_fraction<std::chrono::milliseconds>(msg.time).count()), 3, out + patch.offset);
+                break;
+            case pattern_op::micros:
+                fmt_helper::write_padded(
+                    static_cast<uint32_t>(fmt_helper::time_fraction<std::chrono::microseconds>(msg.time).count()), 6, out + patch.offset);
+                break;
+            default:
+                fmt_helper::write_padded(
+                    static_cast<uint32_t>(fmt_helper::time_fraction<std::chrono::nanoseconds>(msg.time).count()), 9, out + patch.offset);
+                break;
+            }
         }
-        size_t text_size = padinfo_.enabled() ? std::char_traits<char>::length(msg.source.funcname) : 0;
-        ScopedPadder p(text_size, padinfo_, dest);
-        fmt_helper::append_string_view(msg.source.funcname, dest);
+        return;
     }
-};
-
-// print elapsed time since last message
-template<typename ScopedPadder, typename Units>
-class elapsed_formatter final : public flag_formatter
-{
-public:
-    using DurationUnits = Units;
 
-    explicit elapsed_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-        , last_message_time_(log_clock::now())
-    {}
-
-    void format(const details::log_msg &msg, const std::tm &, memory_buf_t &dest) override
+    cache.patches.clear();
+    for (uint32_t i = 0; i < run.size; i++)
     {
-        auto delta = (std::max)(msg.time - last_message_time_, log_clock::duration::zero());
-        auto delta_units = std::chrono::duration_cast<DurationUnits>(delta);
-        last_message_time_ = msg.time;
-        auto delta_count = static_cast<size_t>(delta_units.count());
-        auto n_digits = static_cast<size_t>(ScopedPadder::count_digits(delta_count));
-        ScopedPadder p(n_digits, padinfo_, dest);
-        fmt_helper::append_int(delta_count, dest);
+        const auto &instr = instrs[i];
+        if (instr.op == pattern_op::millis || instr.op == pattern_op::micros || instr.op == pattern_op::nanos)
+        {
+            details::pattern_time_cache::patch patch;
+            patch.offset = static_cast<uint32_t>(dest.size() - start);
+            patch.op = instr.op;
+            cache.patches.push_back(patch);
+        }
+        if (instr.padding.enabled())
+        {
+            run_<details::scoped_padder>(instr, msg, dest);
+        }
+        else
+        {
+            run_<details::null_scoped_padder>(instr, msg, dest);
+        }
+        // the sub-second digits end the iso datetime
+        if (instr.op == pattern_op::iso_datetime && instr.size > 19)
+        {
+            details::pattern_time_cache::patch patch;
+            patch.op = instr.size == 23 ? pattern_op::millis : (instr.size == 26 ? pattern_op::micros : pattern_op::nanos);
+            patch.offset = static_cast<uint32_t>(dest.size() - start) - (instr.size - 20);
+            cache.patches.push_back(patch);
+        }
     }
-
-private:
-    log_clock::time_point last_message_time_;
-};
+    cache.bytes.assign(dest.data() + start, dest.size() - start);
+    cache.valid = true;
+}
 
 // Full info formatter
 // pattern: [%Y-%m-%d %H:%M:%S.%e] [%n] [%l] %v
-class full_formatter final : public flag_formatter
+SPDLOG_INLINE void pattern_formatter::run_full_(const details::log_msg &msg, memory_buf_t &dest)
 {
-public:
-    explicit full_formatter(padding_info padinfo)
-        : flag_formatter(padinfo)
-    {}
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+    using std::chrono::seconds;
+    namespace fmt_helper = details::fmt_helper;
+    const std::tm &tm_time = cached_tm_;
 
-    void format(const details::log_msg &msg, const std::tm &tm_time, memory_buf_t &dest) override
-    {
-        using std::chrono::duration_cast;
-        using std::chrono::milliseconds;
-        using std::chrono::seconds;
+    // cache the date/time part for the next second.
+    auto duration = msg.time.time_since_epoch();
+    auto secs = duration_cast<seconds>(duration);
 
-        // cache the date/time part for the next second.
-        auto duration = msg.time.time_since_epoch();
-        auto secs = duration_cast<seconds>(duration);
+    if (full_datetime_secs_ != secs || full_datetime_.size() == 0)
+    {
+        full_datetime_.clear();
+        full_datetime_.push_back('[');
+        fmt_helper::append_int(tm_time.tm_year + 1900, full_datetime_);
+        full_datetime_.push_back('-');
 
-        if (cache_timestamp_ != secs || cached_datetime_.size() == 0)
-        {
-            cached_datetime_.clear();
-            cached_datetime_.push_back('[');
-            fmt_helper::append_int(tm_time.tm_year + 1900, cached_datetime_);
-            cached_datetime_.push_back('-');
+        fmt_helper::pad2(tm_time.tm_mon + 1, full_datetime_);
+        full_datetime_.push_back('-');
 
-            fmt_helper::pad2(tm_time.tm_mon + 1, cached_datetime_);
-            cached_datetime_.push_back('-');
+        fmt_helper::pad2(tm_time.tm_mday, full_datetime_);
+        full_datetime_.push_back(' ');
 
-            fmt_helper::pad2(tm_time.tm_mday, cached_datetime_);
-            cached_datetime_.push_back(' ');
+        fmt_helper::pad2(tm_time.tm_hour, full_datetime_);
+        full_datetime_.push_back(':');
 
-            fmt_helper::pad2(tm_time.tm_hour, cached_datetime_);
-            cached_datetime_.push_back(':');
+        fmt_helper::pad2(tm_time.tm_min, full_datetime_);
+        full_datetime_.push_back(':');
 
-            fmt_helper::pad2(tm_time.tm_min, cached_datetime_);
-            cached_datetime_.push_back(':');
+        fmt_helper::pad2(tm_time.tm_sec, full_datetime_);
+        full_datetime_.push_back('.');
 
-            fmt_helper::pad2(tm_time.tm_sec, cached_datetime_);
-            cached_datetime_.push_back('.');
+        full_datetime_secs_ = secs;
+    }
+    dest.append(full_datetime_.begin(), full_datetime_.end());
 
-            cache_timestamp_ = secs;
-        }
-        dest.append(cached_datetime_.begin(), cached_datetime_.end());
+    auto millis = fmt_helper::time_fraction<milliseconds>(msg.time);
+    fmt_helper::pad3(static_cast<uint32_t>(millis.count()), dest);
+    dest.push_back(']');
+    dest.push_back(' ');
 
-        auto millis = fmt_helper::time_fraction<milliseconds>(msg.time);
-        fmt_helper::pad3(static_cast<uint32_t>(millis.count()), dest);
+    // append logger name if exists
+    if (msg.logger_name.size() > 0)
+    {
+        dest.push_back('[');
+        fmt_helper::append_string_view(msg.logger_name, dest);
         dest.push_back(']');
         dest.push_back(' ');
+    }
 
-        // append logger name if exists
-        if (msg.logger_name.size() > 0)
-        {
-            dest.push_back('[');
-            fmt_helper::append_string_view(msg.logger_name, dest);
-            dest.push_back(']');
-            dest.push_back(' ');
-        }
+    dest.push_back('[');
+    // wrap the level name with color
+    msg.color_range_start = dest.size();
+    fmt_helper::append_string_view(level::to_string_view(msg.level), dest);
+    msg.color_range_end = dest.size();
+    dest.push_back(']');
+    dest.push_back(' ');
 
+    // add source location if present
+    if (!msg.source.empty())
+    {
         dest.push_back('[');
-        // wrap the level name with color
-        msg.color_range_start = dest.size();
-        // fmt_helper::append_string_view(level::to_c_str(msg.level), dest);
-        fmt_helper::append_string_view(level::to_string_view(msg.level), dest);
-        msg.color_range_end = dest.size();
+        fmt_helper::append_string_view(details::short_filename(msg.source.filename), dest);
+        dest.push_back(':');
+        fmt_helper::append_int(msg.source.line, dest);
         dest.push_back(']');
         dest.push_back(' ');
-
-        // add source location if present
-        if (!msg.source.empty())
-        {
-            dest.push_back('[');
-            const char *filename = details::short_filename_formatter<details::null_scoped_padder>::basename(msg.source.filename);
-            fmt_helper::append_string_view(filename, dest);
-            dest.push_back(':');
-            fmt_helper::append_int(msg.source.line, dest);
-            dest.push_back(']');
-            dest.push_back(' ');
-        }
-        // fmt_helper::append_string_view(msg.msg(), dest);
-        fmt_helper::append_string_view(msg.payload, dest);
     }
-
-private:
-    std::chrono::seconds cache_timestamp_{0};
-    memory_buf_t cached_datetime_;
-};
-
-} // namespace details
-
-SPDLOG_INLINE pattern_formatter::pattern_formatter(
-    std::string pattern, pattern_time_type time_type, std::string eol, custom_flags custom_user_flags)
-    : pattern_(std::move(pattern))
-    , eol_(std::move(eol))
-    , pattern_time_type_(time_type)
-    , last_log_secs_(0)
-    , custom_handlers_(std::move(custom_user_flags))
-{
-    std::memset(&cached_tm_, 0, sizeof(cached_tm_));
-    compile_pattern_(pattern_);
-}
-
-// use by default full formatter for if pattern is not given
-SPDLOG_INLINE pattern_formatter::pattern_formatter(pattern_time_type time_type, std::string eol)
-    : pattern_("%+")
-    , eol_(std::move(eol))
-    , pattern_time_type_(time_type)
-    , last_log_secs_(0)
-{
-    std::memset(&cached_tm_, 0, sizeof(cached_tm_));
-    formatters_.push_back(details::make_unique<details::full_formatter>(details::padding_info{}));
+    fmt_helper::append_string_view(msg.payload, dest);
+    fmt_helper::append_fields(msg.fields, msg.fields_n, dest);
 }
 
-SPDLOG_INLINE std::unique_ptr<formatter> pattern_formatter::clone() const
+SPDLOG_INLINE void pattern_formatter::emit_(details::pattern_op op, details::padding_info padding, uint32_t arg)
 {
-    custom_flags cloned_custom_formatters;
-    for (auto &it : custom_handlers_)
-    {
-        cloned_custom_formatters[it.first] = it.second->clone();
-    }
-    return details::make_unique<pattern_formatter>(pattern_, pattern_time_type_, eol_, std::move(cloned_custom_formatters));
+    details::pattern_instr instr;
+    instr.op = op;
+    instr.arg = arg;
+    instr.size = 0;
+    instr.padding = padding;
+    program_.push_back(instr);
 }
 
-SPDLOG_INLINE void pattern_formatter::format(const details::log_msg &msg, memory_buf_t &dest)
+// consecutive literals are merged into one instruction
+SPDLOG_INLINE void pattern_formatter::emit_literal_(const char *chars, size_t size)
 {
-    auto secs = std::chrono::duration_cast<std::chrono::seconds>(msg.time.time_since_epoch());
-    if (secs != last_log_secs_)
-    {
-        cached_tm_ = get_time_(msg);
-        last_log_secs_ = secs;
-    }
-
-    for (auto &f : formatters_)
+    if (program_.empty() || program_.back().op != details::pattern_op::literal)
     {
-        f->format(msg, cached_tm_, dest);
+        emit_(details::pattern_op::literal, details::padding_info{}, static_cast<uint32_t>(literals_.size()));
     }
-    // write eol
-    details::fmt_helper::append_string_view(eol_, dest);
-}
-
-SPDLOG_INLINE void pattern_formatter::set_pattern(std::string pattern)
-{
-    pattern_ = std::move(pattern);
-    compile_pattern_(pattern_);
+    literals_.append(chars, size);
+    program_.back().size += static_cast<uint32_t>(size);
 }
 
-SPDLOG_INLINE std::tm pattern_formatter::get_time_(const details::log_msg &msg)
+// elapsed: arg is the index of the last message time, size the units
+SPDLOG_INLINE void pattern_formatter::emit_elapsed_(details::elapsed_units units, details::padding_info padding)
 {
-    if (pattern_time_type_ == pattern_time_type::local)
-    {
-        return details::os::localtime(log_clock::to_time_t(msg.time));
-    }
-    return details::os::gmtime(log_clock::to_time_t(msg.time));
+    emit_(details::pattern_op::elapsed, padding, static_cast<uint32_t>(elapsed_last_times_.size()));
+    program_.back().size = static_cast<uint32_t>(units);
+    elapsed_last_times_.push_back(log_clock::now());
 }
 
-template<typename Padder>
 SPDLOG_INLINE void pattern_formatter::handle_flag_(char flag, details::padding_info padding)
 {
+    using details::pattern_op;
+
     // process custom flags
     auto it = custom_handlers_.find(flag);
     if (it != custom_handlers_.end())
     {
         auto custom_handler = it->second->clone();
         custom_handler->set_padding_info(padding);
-        formatters_.push_back(std::move(custom_handler));
+        emit_(pattern_op::custom, padding, static_cast<uint32_t>(custom_formatters_.size()));
+        custom_formatters_.push_back(std::move(custom_handler));
         return;
     }
 
@@ -1096,184 +960,181 @@ SPDLOG_INLINE void pattern_formatter::handle_flag_(char flag, details::padding_i
     switch (flag)
     {
     case ('+'): // default formatter
-        formatters_.push_back(details::make_unique<details::full_formatter>(padding));
+        emit_(pattern_op::full, padding);
         break;
 
-    case 'n': // logger name
-        formatters_.push_back(details::make_unique<details::name_formatter<Padder>>(padding));
+    case ('n'): // logger name
+        emit_(pattern_op::name, padding);
         break;
 
-    case 'l': // level
-        formatters_.push_back(details::make_unique<details::level_formatter<Padder>>(padding));
+    case ('l'): // level
+        emit_(pattern_op::level, padding);
         break;
 
-    case 'L': // short level
-        formatters_.push_back(details::make_unique<details::short_level_formatter<Padder>>(padding));
+    case ('L'): // short level
+        emit_(pattern_op::short_level, padding);
         break;
 
     case ('t'): // thread id
-        formatters_.push_back(details::make_unique<details::t_formatter<Padder>>(padding));
+        emit_(pattern_op::thread_id, padding);
         break;
 
     case ('v'): // the message text
-        formatters_.push_back(details::make_unique<details::v_formatter<Padder>>(padding));
+        emit_(pattern_op::payload, padding);
         break;
 
     case ('a'): // weekday
-        formatters_.push_back(details::make_unique<details::a_formatter<Padder>>(padding));
+        emit_(pattern_op::weekday, padding);
         break;
 
     case ('A'): // short weekday
-        formatters_.push_back(details::make_unique<details::A_formatter<Padder>>(padding));
+        emit_(pattern_op::full_weekday, padding);
         break;
 
     case ('b'):
     case ('h'): // month
-        formatters_.push_back(details::make_unique<details::b_formatter<Padder>>(padding));
+        emit_(pattern_op::month, padding);
         break;
 
     case ('B'): // short month
-        formatters_.push_back(details::make_unique<details::B_formatter<Padder>>(padding));
+        emit_(pattern_op::full_month, padding);
         break;
 
     case ('c'): // datetime
-        formatters_.push_back(details::make_unique<details::c_formatter<Padder>>(padding));
+        emit_(pattern_op::datetime, padding);
         break;
 
     case ('C'): // year 2 digits
-        formatters_.push_back(details::make_unique<details::C_formatter<Padder>>(padding));
+        emit_(pattern_op::year2, padding);
         break;
 
     case ('Y'): // year 4 digits
-        formatters_.push_back(details::make_unique<details::Y_formatter<Padder>>(padding));
+        emit_(pattern_op::year4, padding);
         break;
 
     case ('D'):
     case ('x'): // datetime MM/DD/YY
-        formatters_.push_back(details::make_unique<details::D_formatter<Padder>>(padding));
+        emit_(pattern_op::date_mdy, padding);
         break;
 
     case ('m'): // month 1-12
-        formatters_.push_back(details::make_unique<details::m_formatter<Padder>>(padding));
+        emit_(pattern_op::month_num, padding);
         break;
 
     case ('d'): // day of month 1-31
-        formatters_.push_back(details::make_unique<details::d_formatter<Padder>>(padding));
+        emit_(pattern_op::day, padding);
         break;
 
     case ('H'): // hours 24
-        formatters_.push_back(details::make_unique<details::H_formatter<Padder>>(padding));
+        emit_(pattern_op::hour24, padding);
         break;
 
     case ('I'): // hours 12
-        formatters_.push_back(details::make_unique<details::I_formatter<Padder>>(padding));
+        emit_(pattern_op::hour12, padding);
         break;
 
     case ('M'): // minutes
-        formatters_.push_back(details::make_unique<details::M_formatter<Padder>>(padding));
+        emit_(pattern_op::minute, padding);
         break;
 
     case ('S'): // seconds
-        formatters_.push_back(details::make_unique<details::S_formatter<Padder>>(padding));
+        emit_(pattern_op::second, padding);
         break;
 
     case ('e'): // milliseconds
-        formatters_.push_back(details::make_unique<details::e_formatter<Padder>>(padding));
+        emit_(pattern_op::millis, padding);
         break;
 
     case ('f'): // microseconds
-        formatters_.push_back(details::make_unique<details::f_formatter<Padder>>(padding));
+        emit_(pattern_op::micros, padding);
         break;
 
     case ('F'): // nanoseconds
-        formatters_.push_back(details::make_unique<details::F_formatter<Padder>>(padding));
+        emit_(pattern_op::nanos, padding);
         break;
 
     case ('E'): // seconds since epoch
-        formatters_.push_back(details::make_unique<details::E_formatter<Padder>>(padding));
+        emit_(pattern_op::epoch, padding);
         break;
 
     case ('p'): // am/pm
-        formatters_.push_back(details::make_unique<details::p_formatter<Padder>>(padding));
+        emit_(pattern_op::ampm, padding);
         break;
 
     case ('r'): // 12 hour clock 02:55:02 pm
-        formatters_.push_back(details::make_unique<details::r_formatter<Padder>>(padding));
+        emit_(pattern_op::time12, padding);
         break;
 
     case ('R'): // 24-hour HH:MM time
-        formatters_.push_back(details::make_unique<details::R_formatter<Padder>>(padding));
+        emit_(pattern_op::time_hm, padding);
         break;
 
     case ('T'):
     case ('X'): // ISO 8601 time format (HH:MM:SS)
-        formatters_.push_back(details::make_unique<details::T_formatter<Padder>>(padding));
+        emit_(pattern_op::time_hms, padding);
         break;
 
     case ('z'): // timezone
-        formatters_.push_back(details::make_unique<details::z_formatter<Padder>>(padding));
+        emit_(pattern_op::tz_offset, padding);
         break;
 
     case ('P'): // pid
-        formatters_.push_back(details::make_unique<details::pid_formatter<Padder>>(padding));
+        emit_(pattern_op::pid, padding);
         break;
 
     case ('^'): // color range start
-        formatters_.push_back(details::make_unique<details::color_start_formatter>(padding));
+        emit_(pattern_op::color_start, padding);
         break;
 
     case ('$'): // color range end
-        formatters_.push_back(details::make_unique<details::color_stop_formatter>(padding));
+        emit_(pattern_op::color_stop, padding);
         break;
 
     case ('@'): // source location (filename:filenumber)
-        formatters_.push_back(details::make_unique<details::source_location_formatter<Padder>>(padding));
+        emit_(pattern_op::source_loc, padding);
         break;
 
     case ('s'): // short source filename - without directory name
-        formatters_.push_back(details::make_unique<details::short_filename_formatter<Padder>>(padding));
+        emit_(pattern_op::short_filename, padding);
         break;
 
     case ('g'): // full source filename
-        formatters_.push_back(details::make_unique<details::source_filename_formatter<Padder>>(padding));
+        emit_(pattern_op::filename, padding);
         break;
 
     case ('#'): // source line number
-        formatters_.push_back(details::make_unique<details::source_linenum_formatter<Padder>>(padding));
+        emit_(pattern_op::line, padding);
         break;
 
     case ('!'): // source funcname
-        formatters_.push_back(details::make_unique<details::source_funcname_formatter<Padder>>(padding));
+        emit_(pattern_op::funcname, padding);
         break;
 
     case ('%'): // % char
-        formatters_.push_back(details::make_unique<details::ch_formatter>('%'));
+        emit_literal_("%", 1);
         break;
 
     case ('u'): // elapsed time since last log message in nanos
-        formatters_.push_back(details::make_unique<details::elapsed_formatter<Padder, std::chrono::nanoseconds>>(padding));
+        emit_elapsed_(details::elapsed_units::nanos, padding);
         break;
 
     case ('i'): // elapsed time since last log message in micros
-        formatters_.push_back(details::make_unique<details::elapsed_formatter<Padder, std::chrono::microseconds>>(padding));
+        emit_elapsed_(details::elapsed_units::micros, padding);
         break;
 
     case ('o'): // elapsed time since last log message in millis
-        formatters_.push_back(details::make_unique<details::elapsed_formatter<Padder, std::chrono::milliseconds>>(padding));
+        emit_elapsed_(details::elapsed_units::millis, padding);
         break;
 
     case ('O'): // elapsed time since last log message in seconds
-        formatters_.push_back(details::make_unique<details::elapsed_formatter<Padder, std::chrono::seconds>>(padding));
+        emit_elapsed_(details::elapsed_units::seconds, padding);
         break;
 
     default: // Unknown flag appears as is
-        auto unknown_flag = details::make_unique<details::aggregate_formatter>();
-
         if (!padding.truncate_)
         {
-            unknown_flag->add_ch('%');
-            unknown_flag->add_ch(flag);
-            formatters_.push_back((std::move(unknown_flag)));
+            const char unknown_flag[] = {'%', flag};
+            emit_literal_(unknown_flag, 2);
         }
         // fix issue #1617 (prev char was '!' and should have been treated as funcname flag instead of truncating flag)
         // spdlog::set_pattern("[%10!] %v") => "[      main] some message"
@@ -1281,9 +1142,8 @@ SPDLOG_INLINE void pattern_formatter::handle_flag_(char flag, details::padding_i
         else
         {
             padding.truncate_ = false;
-            formatters_.push_back(details::make_unique<details::source_funcname_formatter<Padder>>(padding));
-            unknown_flag->add_ch(flag);
-            formatters_.push_back((std::move(unknown_flag)));
+            emit_(pattern_op::funcname, padding);
+            emit_literal_(&flag, 1);
         }
 
         break;
@@ -1349,29 +1209,20 @@ SPDLOG_INLINE details::padding_info pattern_formatter::handle_padspec_(std::stri
 SPDLOG_INLINE void pattern_formatter::compile_pattern_(const std::string &pattern)
 {
     auto end = pattern.end();
-    std::unique_ptr<details::aggregate_formatter> user_chars;
-    formatters_.clear();
+    program_.clear();
+    literals_.clear();
+    custom_formatters_.clear();
+    time_caches_.clear();
+    elapsed_last_times_.clear();
     for (auto it = pattern.begin(); it != end; ++it)
     {
         if (*it == '%')
         {
-            if (user_chars) // append user chars found so far
-            {
-                formatters_.push_back(std::move(user_chars));
-            }
-
             auto padding = handle_padspec_(++it, end);
 
             if (it != end)
             {
-                if (padding.enabled())
-                {
-                    handle_flag_<details::scoped_padder>(*it, padding);
-                }
-                else
-                {
-                    handle_flag_<details::null_scoped_padder>(*it, padding);
-                }
+                handle_flag_(*it, padding);
             }
             else
             {
@@ -1380,16 +1231,108 @@ SPDLOG_INLINE void pattern_formatter::compile_pattern_(const std::string &patter
         }
         else // chars not following the % sign should be displayed as is
         {
-            if (!user_chars)
+            emit_literal_(&*it, 1);
+        }
+    }
+    fuse_datetime_();
+    build_time_runs_();
+}
+
+// replace "%Y-%m-%d %H:%M:%S" (and a following ".%e", ".%f" or ".%F") without padding
+// by one iso_datetime instruction, rendered by fmt_helper::write_datetime().
+SPDLOG_INLINE void pattern_formatter::fuse_datetime_()
+{
+    using details::pattern_op;
+    static const pattern_op fields[] = {
+        pattern_op::year4, pattern_op::month_num, pattern_op::day, pattern_op::hour24, pattern_op::minute, pattern_op::second};
+    static const char separators[] = "-- ::";
+
+    auto is_flag = [this](size_t i, pattern_op op) {
+        return i < program_.size() && program_[i].op == op && !program_[i].padding.enabled();
+    };
+    auto is_char = [this](size_t i, char ch) {
+        return i < program_.size() && program_[i].op == pattern_op::literal && program_[i].size == 1 && literals_[program_[i].arg] == ch;
+    };
+
+    std::vector<details::pattern_instr> program;
+    program.reserve(program_.size());
+    for (size_t i = 0; i < program_.size(); i++)
+    {
+        size_t end = i;
+        bool matched = true;
+        for (size_t field = 0; field < 6 && matched; field++)
+        {
+            matched = (field == 0 || is_char(end++, separators[field - 1])) && is_flag(end++, fields[field]);
+        }
+        if (!matched)
+        {
+            program.push_back(program_[i]);
+            continue;
+        }
+
+        details::pattern_instr datetime;
+        datetime.op = pattern_op::iso_datetime;
+        datetime.arg = 0;
+        datetime.size = 19;
+        if (is_char(end, '.'))
+        {
+            if (is_flag(end + 1, pattern_op::millis))
+            {
+                datetime.size = 23;
+            }
+            else if (is_flag(end + 1, pattern_op::micros))
+            {
+                datetime.size = 26;
+            }
+            else if (is_flag(end + 1, pattern_op::nanos))
             {
-                user_chars = details::make_unique<details::aggregate_formatter>();
+                datetime.size = 29;
             }
-            user_chars->add_ch(*it);
+            end += datetime.size > 19 ? 2 : 0;
         }
+        program.push_back(datetime);
+        i = end - 1;
     }
-    if (user_chars) // append raw chars found so far
+    program_.swap(program);
+}
+
+// group the runs of instructions whose output only changes once a second (date and
+// time fields, the literals between them and the sub-second fields) under a time_run
+// instruction, so they are rendered once a second.
+SPDLOG_INLINE void pattern_formatter::build_time_runs_()
+{
+    using details::pattern_op;
+    std::vector<details::pattern_instr> program;
+    program.reserve(program_.size());
+    needs_tm_ = false;
+    for (size_t i = 0; i < program_.size();)
     {
-        formatters_.push_back(std::move(user_chars));
+        size_t time_fields = 0;
+        size_t end = i;
+        while (end < program_.size() && details::cacheable_per_second(program_[end]))
+        {
+            time_fields += details::uses_tm(program_[end].op) ? size_t(1) : size_t(0);
+            end++;
+        }
+        if (time_fields > 0 && end - i > 1)
+        {
+            details::pattern_instr run;
+            run.op = pattern_op::time_run;
+            run.arg = static_cast<uint32_t>(time_caches_.size());
+            run.size = static_cast<uint32_t>(end - i);
+            program.push_back(run);
+            time_caches_.emplace_back();
+        }
+        else if (end == i)
+        {
+            end = i + 1;
+        }
+        for (; i < end; i++)
+        {
+            needs_tm_ = needs_tm_ || details::uses_tm(program_[i].op);
+            program.push_back(program_[i]);
+        }
     }
+    program_.swap(program);
 }
 } // namespace spdlog
@@ -61,6 +61,92 @@ protected:
     padding_info padinfo_;
 };
 
+// operation of a compiled pattern instruction
+enum class pattern_op : unsigned char
+{
+    literal,        // user chars
+    name,           // %n
+    level,          // %l
+    short_level,    // %L
+    thread_id,      // %t
+    payload,        // %v
+    weekday,        // %a
+    full_weekday,   // %A
+    month,          // %b %h
+    full_month,     // %B
+    datetime,       // %c
+    year2,          // %C
+    year4,          // %Y
+    date_mdy,       // %D %x
+    month_num,      // %m
+    day,            // %d
+    hour24,         // %H
+    hour12,         // %I
+    minute,         // %M
+    second,         // %S
+    millis,         // %e
+    micros,         // %f
+    nanos,          // %F
+    epoch,          // %E
+    ampm,           // %p
+    time12,         // %r
+    time_hm,        // %R
+    time_hms,       // %T %X
+    tz_offset,      // %z
+    pid,            // %P
+    color_start,    // %^
+    color_stop,     // %$
+    source_loc,     // %@
+    short_filename, // %s
+    filename,       // %g
+    line,           // %#
+    funcname,       // %!
+    elapsed,        // %u %i %o %O
+    full,           // %+
+    iso_datetime,   // %Y-%m-%d %H:%M:%S, optionally followed by .%e .%f or .%F
+    custom,         // user defined flag
+    time_run        // cached output of the next instructions
+};
+
+// instruction of a compiled pattern. trivially copyable, so the program of
+// a pattern is a flat array that is copied as is.
+struct pattern_instr
+{
+    pattern_op op;
+    // literal: offset of the chars. elapsed: index of its last message time (and
+    // elapsed_units the units). custom: index of the custom flag formatter.
+    // time_run: index of its cache.
+    uint32_t arg;
+    // literal, iso_datetime: number of chars. time_run: number of instructions it covers.
+    uint32_t size;
+    padding_info padding;
+};
+
+// output of a time_run instruction - the fields that change once a second (and
+// the literals between them), rendered for the current second. the sub-second
+// fields are patched into a copy of the bytes for each message.
+struct pattern_time_cache
+{
+    struct patch
+    {
+        uint32_t offset;
+        pattern_op op;
+    };
+
+    bool valid = false;
+    std::string bytes;
+    std::vector<patch> patches;
+};
+
+// units of the elapsed time flags
+enum class elapsed_units : uint32_t
+{
+    nanos,
+    micros,
+    millis,
+    seconds
+};
+
 } // namespace details
 
 class SPDLOG_API custom_flag_formatter : public details::flag_formatter
@@ -90,11 +176,18 @@ public:
 
     std::unique_ptr<formatter> clone() const override;
     void format(const details::log_msg &msg, memory_buf_t &dest) override;
+    // same for the same pattern, time type and eol. 0 if custom flags are used.
+    size_t format_id() const override;
+
+    // the format id of a pattern without custom flags. shared with the formatters
+    // that produce the same output (see static_pattern_formatter.h).
+    static size_t format_id_of(const std::string &pattern, pattern_time_type time_type, const std::string &eol);
 
     template<typename T, typename... Args>
     pattern_formatter &add_flag(char flag, Args&&...args)
     {
         custom_handlers_[flag] = details::make_unique<T>(std::forward<Args>(args)...);
+        format_id_ = 0;
         return *this;
     }
     void set_pattern(std::string pattern);
@@ -105,12 +198,36 @@ private:
     pattern_time_type pattern_time_type_;
     std::tm cached_tm_;
     std::chrono::seconds last_log_secs_;
-    std::vector<std::unique_ptr<details::flag_formatter>> formatters_;
     custom_flags custom_handlers_;
-
+    size_t format_id_ = 0;
+
+    // the compiled pattern - run by format() in order
+    std::vector<details::pattern_instr> program_;
+    std::string literals_;
+    std::vector<std::unique_ptr<custom_flag_formatter>> custom_formatters_;
+    std::vector<details::pattern_time_cache> time_caches_;
+    bool needs_tm_ = true;
+    // state of the instructions
+    std::vector<log_clock::time_point> elapsed_last_times_;
+    std::chrono::seconds full_datetime_secs_{0};
+    memory_buf_t full_datetime_;
+
+    // clone() - copy the compiled program of other
+    pattern_formatter(const pattern_formatter &other, custom_flags custom_user_flags);
+
+    void update_format_id_();
     std::tm get_time_(const details::log_msg &msg);
-    template<typename Padder>
     void handle_flag_(char flag, details::padding_info padding);
+    void emit_(details::pattern_op op, details::padding_info padding, uint32_t arg = 0);
+    void emit_literal_(const char *chars, size_t size);
+    void emit_elapsed_(details::elapsed_units units, details::padding_info padding);
+    template<typename ScopedPadder>
+    void run_(const details::pattern_instr &instr, const details::log_msg &msg, memory_buf_t &dest);
+    void run_full_(const details::log_msg &msg, memory_buf_t &dest);
+    void run_time_(
+        const details::pattern_instr &run, const details::pattern_instr *instrs, const details::log_msg &msg, memory_buf_t &dest);
+    void fuse_datetime_();
+    void build_time_runs_();
 
     // Extract given pad spec (e.g. %8X)
     // Advance the given it pass the end of the padding spec found (if any)
@@ -40,10 +40,12 @@ protected:
     void sink_it_(const details::log_msg &msg) override
     {
         const android_LogPriority priority = convert_to_android_(msg.level);
-        memory_buf_t formatted;
+        details::scratch_buffer scratch;
+        memory_buf_t &formatted = scratch.get();
         if (use_raw_msg_)
         {
             details::fmt_helper::append_string_view(msg.payload, formatted);
+            details::fmt_helper::append_fields(msg.fields, msg.fields_n, formatted);
         }
         else
         {
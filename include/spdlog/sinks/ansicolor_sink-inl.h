@@ -18,7 +18,7 @@ SPDLOG_INLINE ansicolor_sink<ConsoleMutex>::ansicolor_sink(FILE *target_file, co
     : target_file_(target_file)
     , mutex_(ConsoleMutex::mutex())             // 单例全局只有一个控制台锁
     , formatter_(details::make_unique<spdlog::pattern_formatter>())
-
+    , formatter_id_(formatter_->format_id())
 {
     set_color_mode(mode);
     colors_[level::trace] = to_string_(white);
@@ -40,13 +40,55 @@ SPDLOG_INLINE void ansicolor_sink<ConsoleMutex>::set_color(level::level_enum col
 template<typename ConsoleMutex>
 SPDLOG_INLINE void ansicolor_sink<ConsoleMutex>::log(const details::log_msg &msg)
 {
-    // Wrap the originally formatted message in color codes.
-    // If color is not supported in the terminal, log as is instead.
     std::lock_guard<mutex_t> lock(mutex_);
     msg.color_range_start = 0;
     msg.color_range_end = 0;
-    memory_buf_t formatted;
+    details::scratch_buffer scratch;
+    memory_buf_t &formatted = scratch.get();
     formatter_->format(msg, formatted);
+    print_formatted_(msg, formatted);
+}
+
+template<typename ConsoleMutex>
+SPDLOG_INLINE size_t ansicolor_sink<ConsoleMutex>::formatter_id() const
+{
+    return formatter_id_.load(std::memory_order_relaxed);
+}
+
+template<typename ConsoleMutex>
+SPDLOG_INLINE size_t ansicolor_sink<ConsoleMutex>::format_and_log(const details::log_msg &msg, memory_buf_t &dest)
+{
+    std::lock_guard<mutex_t> lock(mutex_);
+    msg.color_range_start = 0;
+    msg.color_range_end = 0;
+    formatter_->format(msg, dest);
+    print_formatted_(msg, dest);
+    return formatter_id_.load(std::memory_order_relaxed);
+}
+
+// the color range was set in msg by the sink that formatted it
+template<typename ConsoleMutex>
+SPDLOG_INLINE void ansicolor_sink<ConsoleMutex>::log_formatted(const details::log_msg &msg, const memory_buf_t &formatted, size_t format_id)
+{
+    std::lock_guard<mutex_t> lock(mutex_);
+    if (format_id != 0 && format_id == formatter_id_.load(std::memory_order_relaxed))
+    {
+        print_formatted_(msg, formatted);
+        return;
+    }
+    msg.color_range_start = 0;
+    msg.color_range_end = 0;
+    details::scratch_buffer scratch;
+    memory_buf_t &own_formatted = scratch.get();
+    formatter_->format(msg, own_formatted);
+    print_formatted_(msg, own_formatted);
+}
+
+// Wrap the originally formatted message in color codes.
+// If color is not supported in the terminal, log as is instead.
+template<typename ConsoleMutex>
+SPDLOG_INLINE void ansicolor_sink<ConsoleMutex>::print_formatted_(const details::log_msg &msg, const memory_buf_t &formatted)
+{
     if (should_do_colors_ && msg.color_range_end > msg.color_range_start)
     {
         // before color range
@@ -77,6 +119,7 @@ SPDLOG_INLINE void ansicolor_sink<ConsoleMutex>::set_pattern(const std::string &
 {
     std::lock_guard<mutex_t> lock(mutex_);
     formatter_ = std::unique_ptr<spdlog::formatter>(new pattern_formatter(pattern));
+    formatter_id_.store(formatter_->format_id(), std::memory_order_relaxed);
 }
 
 template<typename ConsoleMutex>
@@ -84,6 +127,7 @@ SPDLOG_INLINE void ansicolor_sink<ConsoleMutex>::set_formatter(std::unique_ptr<s
 {
     std::lock_guard<mutex_t> lock(mutex_);
     formatter_ = std::move(sink_formatter);
+    formatter_id_.store(formatter_ ? formatter_->format_id() : 0, std::memory_order_relaxed);
 }
 
 template<typename ConsoleMutex>
@@ -5,6 +5,7 @@
 
 #include <spdlog/details/console_globals.h>
 #include <spdlog/details/null_mutex.h>
+#include <spdlog/details/scratch_buffer.h>
 #include <spdlog/sinks/sink.h>
 #include <memory>
 #include <mutex>
@@ -43,6 +44,9 @@ public:
     void flush() override;
     void set_pattern(const std::string &pattern) final;
     void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override;
+    size_t formatter_id() const override;
+    size_t format_and_log(const details::log_msg &msg, memory_buf_t &dest) override;
+    void log_formatted(const details::log_msg &msg, const memory_buf_t &formatted, size_t format_id) override;
 
     // Formatting codes
     const string_view_t reset = "\033[m";
@@ -84,7 +88,9 @@ private:
     mutex_t &mutex_;                    // 保证全家只用一个锁
     bool should_do_colors_;
     std::unique_ptr<spdlog::formatter> formatter_;
+    std::atomic<size_t> formatter_id_;
     std::array<std::string, level::n_levels> colors_;
+    void print_formatted_(const details::log_msg &msg, const memory_buf_t &formatted);
     void print_ccode_(const string_view_t &color_code);
     void print_range_(const memory_buf_t &formatted, size_t start, size_t end);
     static std::string to_string_(const string_view_t &sv);
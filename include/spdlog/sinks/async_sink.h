@@ -0,0 +1,305 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Sink wrapper that writes to the wrapped sink from a thread of its own.
+// The logging thread only copies the message to a small queue, so a slow or
+// stalled sink (network, slow disk) does not add its latency to the log calls,
+// nor to the other sinks of the logger. Wrap each slow sink of a logger to fan
+// out to them concurrently:
+//
+//   auto tcp = std::make_shared<spdlog::sinks::async_sink>(tcp_sink);
+//   auto logger = std::make_shared<spdlog::logger>("net", spdlog::sinks_init_list{file_sink, tcp});
+//
+// flush() is asynchronous too - the wrapped sink is flushed by the worker after
+// the messages logged before it. The destructor writes the queued messages and
+// joins the worker, for up to shutdown_timeout. A worker still stuck in the
+// wrapped sink after that is detached (the rest of the queue is dropped).
+
+#include <spdlog/async_logger.h>
+#include <spdlog/details/log_msg_buffer.h>
+#include <spdlog/details/mpmc_blocking_q.h>
+#include <spdlog/sinks/sink.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// local to this header (undefined at its end)
+#ifndef SPDLOG_NO_EXCEPTIONS
+#define SPDLOG_ASYNC_SINK_CATCH()                                                                                                          \
+    catch (const std::exception &ex)                                                                                                       \
+    {                                                                                                                                      \
+        report_error_(ex.what());                                                                                                          \
+    }                                                                                                                                      \
+    catch (...)                                                                                                                            \
+    {                                                                                                                                      \
+        report_error_("Unknown exception in async_sink");                                                                                  \
+    }
+#else
+#define SPDLOG_ASYNC_SINK_CATCH()
+#endif
+
+namespace spdlog {
+namespace sinks {
+
+class async_sink final : public sink
+{
+public:
+    explicit async_sink(sink_ptr wrapped_sink, size_t queue_size = default_queue_size,
+        async_overflow_policy overflow_policy = async_overflow_policy::block,
+        std::chrono::milliseconds shutdown_timeout = std::chrono::seconds(5))
+        : sink_(std::move(wrapped_sink))
+        , overflow_policy_(overflow_policy)
+        , shutdown_timeout_(shutdown_timeout)
+        , state_(std::make_shared<worker_state>(sink_, queue_size))
+    {
+        auto state = state_;
+        worker_ = std::thread([state] {
+            worker_loop_(*state);
+            std::lock_guard<std::mutex> lock(state->exit_mutex);
+            state->exited = true;
+            state->exit_cv.notify_all();
+        });
+    }
+
+    async_sink(const async_sink &) = delete;
+    async_sink &operator=(const async_sink &) = delete;
+
+    // the terminate message wakes the worker. it never blocks: while the queue is full the
+    // worker is busy, and a stop flag makes it exit after its current batch instead.
+    ~async_sink() override
+    {
+        SPDLOG_TRY
+        {
+            auto deadline = std::chrono::steady_clock::now() + shutdown_timeout_;
+            item terminate(item_type::terminate);
+            while (!state_->q.try_enqueue(std::move(terminate)))
+            {
+                if (std::chrono::steady_clock::now() >= deadline)
+                {
+                    state_->stop.store(true, std::memory_order_release);
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            bool exited;
+            {
+                std::unique_lock<std::mutex> lock(state_->exit_mutex);
+                exited = state_->exit_cv.wait_until(lock, deadline, [this] { return this->state_->exited; });
+            }
+            if (exited)
+            {
+                worker_.join();
+            }
+            else
+            {
+                // it keeps the wrapped sink and the queue alive until it returns
+                state_->stop.store(true, std::memory_order_release);
+                worker_.detach();
+                report_error_("worker still busy after the shutdown timeout - detached");
+            }
+        }
+        SPDLOG_CATCH_ALL() {}
+    }
+
+    // messages below the wrapped sink's level are not queued at all
+    void log(const details::log_msg &msg) override
+    {
+        if (sink_->should_log(msg.level))
+        {
+            post_(item(msg));
+        }
+    }
+
+    void flush() override
+    {
+        post_(item(item_type::flush));
+    }
+
+    // the wrapped sink is thread safe - set its formatter directly
+    void set_pattern(const std::string &pattern) override
+    {
+        sink_->set_pattern(pattern);
+    }
+
+    void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override
+    {
+        sink_->set_formatter(std::move(sink_formatter));
+    }
+
+    const sink_ptr &wrapped_sink() const
+    {
+        return sink_;
+    }
+
+    // messages lost because the queue was full (overrun_oldest and discard_new policies)
+    size_t dropped_counter() const
+    {
+        return state_->dropped.load(std::memory_order_relaxed);
+    }
+
+    static const size_t default_queue_size = 8192;
+
+private:
+    enum class item_type
+    {
+        log,
+        flush,
+        terminate
+    };
+
+    struct item : details::log_msg_buffer
+    {
+        item_type type{item_type::log};
+
+        item() = default;
+        item(const item &) = delete;
+        item &operator=(const item &) = delete;
+
+// support for vs2013 move
+#if defined(_MSC_VER) && _MSC_VER <= 1800
+        item(item &&other)
+            : details::log_msg_buffer(std::move(other))
+            , type(other.type)
+        {}
+
+        item &operator=(item &&other)
+        {
+            *static_cast<details::log_msg_buffer *>(this) = std::move(other);
+            type = other.type;
+            return *this;
+        }
+#else
+        item(item &&) = default;
+        item &operator=(item &&) = default;
+#endif
+
+        explicit item(const details::log_msg &m)
+            : details::log_msg_buffer(m)
+        {}
+
+        explicit item(item_type the_type)
+            : type(the_type)
+        {}
+    };
+
+    // max number of messages the worker writes at once
+    static const size_t batch_max_items = 64;
+
+    // shared with the worker, which may outlive the async_sink (see the destructor)
+    struct worker_state
+    {
+        worker_state(sink_ptr wrapped_sink, size_t queue_size)
+            : sink(std::move(wrapped_sink))
+            , q(queue_size)
+        {}
+
+        sink_ptr sink;
+        details::mpmc_blocking_queue<item> q;
+        std::atomic<size_t> dropped{0};
+        std::atomic<bool> stop{false}; // exit after the current batch, drop the rest
+        std::mutex exit_mutex;
+        std::condition_variable exit_cv;
+        bool exited = false; // guarded by exit_mutex
+    };
+
+    sink_ptr sink_;
+    async_overflow_policy overflow_policy_;
+    std::chrono::milliseconds shutdown_timeout_;
+    std::shared_ptr<worker_state> state_;
+    std::thread worker_;
+
+    void post_(item &&new_item)
+    {
+        auto &q = state_->q;
+        switch (overflow_policy_)
+        {
+        case async_overflow_policy::block:
+            q.enqueue(std::move(new_item));
+            break;
+        case async_overflow_policy::overrun_oldest:
+            state_->dropped.fetch_add(q.enqueue_nowait(std::move(new_item)), std::memory_order_relaxed);
+            break;
+        case async_overflow_policy::discard_new:
+            if (!q.try_enqueue(std::move(new_item)))
+            {
+                state_->dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            break;
+        }
+    }
+
+    static void worker_loop_(worker_state &state)
+    {
+        std::vector<item> batch(batch_max_items);
+        std::vector<details::log_msg> run;
+        for (;;)
+        {
+            size_t n = state.q.dequeue_bulk(batch.data(), batch.size(), std::chrono::seconds(10));
+            // consecutive messages are written with one call
+            for (size_t i = 0; i < n; i++)
+            {
+                if (batch[i].type == item_type::log)
+                {
+                    run.push_back(batch[i]);
+                    continue;
+                }
+                write_run_(state, run);
+                if (batch[i].type == item_type::terminate)
+                {
+                    flush_(state);
+                    return;
+                }
+                flush_(state);
+            }
+            write_run_(state, run);
+            if (state.stop.load(std::memory_order_acquire))
+            {
+                state.dropped.fetch_add(state.q.size(), std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    static void write_run_(worker_state &state, std::vector<details::log_msg> &run)
+    {
+        if (run.empty())
+        {
+            return;
+        }
+        SPDLOG_TRY
+        {
+            state.sink->log_batch(run.data(), run.size());
+        }
+        SPDLOG_ASYNC_SINK_CATCH()
+        run.clear();
+    }
+
+    // there is no logger to report to
+    static void report_error_(const char *what)
+    {
+        std::fprintf(stderr, "[*** LOG ERROR ***] [async_sink] {%s}\n", what);
+    }
+
+    static void flush_(worker_state &state)
+    {
+        SPDLOG_TRY
+        {
+            state.sink->flush();
+        }
+        SPDLOG_ASYNC_SINK_CATCH()
+    }
+};
+
+} // namespace sinks
+} // namespace spdlog
+
+#undef SPDLOG_ASYNC_SINK_CATCH
@@ -36,11 +36,13 @@
 template<typename Mutex>
 SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::base_sink()
     : formatter_{details::make_unique<spdlog::pattern_formatter>()}
+    , formatter_id_{formatter_->format_id()}
 {}
 
 template<typename Mutex>
 SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::base_sink(std::unique_ptr<spdlog::formatter> formatter)
     : formatter_{std::move(formatter)}
+    , formatter_id_{formatter_ ? formatter_->format_id() : 0}
 {}
 
 template<typename Mutex>
@@ -50,6 +52,13 @@ void SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::log(const details::log_msg &
     sink_it_(msg);
 }
 
+template<typename Mutex>
+void SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::log_batch(const details::log_msg *msgs, size_t count)
+{
+    std::lock_guard<Mutex> lock(mutex_);
+    sink_batch_(msgs, count);
+}
+
 template<typename Mutex>
 void SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::flush()
 {
@@ -62,6 +71,7 @@ void SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::set_pattern(const std::strin
 {
     std::lock_guard<Mutex> lock(mutex_);
     set_pattern_(pattern);
+    formatter_id_.store(formatter_ ? formatter_->format_id() : 0, std::memory_order_relaxed);
 }
 
 template<typename Mutex>
@@ -69,6 +79,52 @@ void SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::set_formatter(std::unique_pt
 {
     std::lock_guard<Mutex> lock(mutex_);
     set_formatter_(std::move(sink_formatter));
+    formatter_id_.store(formatter_ ? formatter_->format_id() : 0, std::memory_order_relaxed);
+}
+
+template<typename Mutex>
+size_t SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::formatter_id() const
+{
+    return writes_formatted_() ? formatter_id_.load(std::memory_order_relaxed) : 0;
+}
+
+template<typename Mutex>
+size_t SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::format_and_log(const details::log_msg &msg, memory_buf_t &dest)
+{
+    std::lock_guard<Mutex> lock(mutex_);
+    // a sink that formats by itself would not use the result
+    if (!writes_formatted_())
+    {
+        sink_it_(msg);
+        return 0;
+    }
+    msg.color_range_start = 0;
+    msg.color_range_end = 0;
+    formatter_->format(msg, dest);
+    sink_formatted_(msg, dest);
+    return formatter_id_.load(std::memory_order_relaxed);
+}
+
+template<typename Mutex>
+void SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::log_formatted(
+    const details::log_msg &msg, const memory_buf_t &formatted, size_t format_id)
+{
+    std::lock_guard<Mutex> lock(mutex_);
+    if (format_id != 0 && format_id == formatter_id_.load(std::memory_order_relaxed))
+    {
+        sink_formatted_(msg, formatted);
+        return;
+    }
+    sink_it_(msg);
+}
+
+template<typename Mutex>
+void SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::sink_batch_(const details::log_msg *msgs, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        sink_it_(msgs[i]);
+    }
 }
 
 template<typename Mutex>
@@ -82,3 +138,15 @@ void SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::set_formatter_(std::unique_p
 {
     formatter_ = std::move(sink_formatter);
 }
+
+template<typename Mutex>
+bool SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::writes_formatted_() const
+{
+    return false;
+}
+
+template<typename Mutex>
+void SPDLOG_INLINE spdlog::sinks::base_sink<Mutex>::sink_formatted_(const details::log_msg &msg, const memory_buf_t &)
+{
+    sink_it_(msg);
+}
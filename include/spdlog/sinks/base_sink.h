@@ -11,6 +11,7 @@
 
 #include <spdlog/common.h>
 #include <spdlog/details/log_msg.h>
+#include <spdlog/details/scratch_buffer.h>
 #include <spdlog/sinks/sink.h>
 
 namespace spdlog {
@@ -30,19 +31,30 @@ public:
     base_sink &operator=(base_sink &&) = delete;
 
     void log(const details::log_msg &msg) final;                       // final 禁用重写
+    void log_batch(const details::log_msg *msgs, size_t count) final;
     void flush() final;
     void set_pattern(const std::string &pattern) final;                // 相当于模板方法 加锁 方便以后不用重复
     void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) final;
+    size_t formatter_id() const final;
+    size_t format_and_log(const details::log_msg &msg, memory_buf_t &dest) final;
+    void log_formatted(const details::log_msg &msg, const memory_buf_t &formatted, size_t format_id) final;
 
 protected:
     // sink formatter
     std::unique_ptr<spdlog::formatter> formatter_;
     Mutex mutex_;                                                      // 为了同步多线程
+    std::atomic<size_t> formatter_id_{0};                              // formatter_->format_id(), read without the mutex
 
     virtual void sink_it_(const details::log_msg &msg) = 0;
+    // called with the mutex held. default is to call sink_it_() for each message.
+    virtual void sink_batch_(const details::log_msg *msgs, size_t count);
     virtual void flush_() = 0;
     virtual void set_pattern_(const std::string &pattern);
     virtual void set_formatter_(std::unique_ptr<spdlog::formatter> sink_formatter);
+
+    // sinks that write the formatted message as is override both (see sink::formatter_id())
+    virtual bool writes_formatted_() const;
+    virtual void sink_formatted_(const details::log_msg &msg, const memory_buf_t &formatted);
 };
 } // namespace sinks
 } // namespace spdlog
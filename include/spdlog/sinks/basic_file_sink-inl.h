@@ -28,11 +28,37 @@ SPDLOG_INLINE const filename_t &basic_file_sink<Mutex>::filename() const
 template<typename Mutex>
 SPDLOG_INLINE void basic_file_sink<Mutex>::sink_it_(const details::log_msg &msg)
 {
-    memory_buf_t formatted;
+    details::scratch_buffer scratch;
+    memory_buf_t &formatted = scratch.get();
     base_sink<Mutex>::formatter_->format(msg, formatted);
     file_helper_.write(formatted);
 }
 
+template<typename Mutex>
+SPDLOG_INLINE bool basic_file_sink<Mutex>::writes_formatted_() const
+{
+    return true;
+}
+
+template<typename Mutex>
+SPDLOG_INLINE void basic_file_sink<Mutex>::sink_formatted_(const details::log_msg &, const memory_buf_t &formatted)
+{
+    file_helper_.write(formatted);
+}
+
+// format the whole batch into one buffer and write it at once
+template<typename Mutex>
+SPDLOG_INLINE void basic_file_sink<Mutex>::sink_batch_(const details::log_msg *msgs, size_t count)
+{
+    details::scratch_buffer scratch;
+    memory_buf_t &formatted = scratch.get();
+    for (size_t i = 0; i < count; i++)
+    {
+        base_sink<Mutex>::formatter_->format(msgs[i], formatted);
+    }
+    file_helper_.write(formatted);
+}
+
 template<typename Mutex>
 SPDLOG_INLINE void basic_file_sink<Mutex>::flush_()
 {
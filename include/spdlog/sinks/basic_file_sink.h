@@ -35,6 +35,9 @@ public:
 
 protected:
     void sink_it_(const details::log_msg &msg) override;
+    bool writes_formatted_() const override;
+    void sink_formatted_(const details::log_msg &msg, const memory_buf_t &formatted) override;
+    void sink_batch_(const details::log_msg *msgs, size_t count) override;
     void flush_() override;
 
 private:
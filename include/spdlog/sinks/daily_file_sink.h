@@ -96,6 +96,19 @@ public:
 
 protected:
     void sink_it_(const details::log_msg &msg) override
+    {
+        details::scratch_buffer scratch;
+        memory_buf_t &formatted = scratch.get();
+        base_sink<Mutex>::formatter_->format(msg, formatted);      //格式化内容 // 为什么要用基类？这里不能直接访问么？？？
+        sink_formatted_(msg, formatted);
+    }
+
+    bool writes_formatted_() const override
+    {
+        return true;
+    }
+
+    void sink_formatted_(const details::log_msg &msg, const memory_buf_t &formatted) override
     {
         auto time = msg.time;
         bool should_rotate = time >= rotation_tp_;
@@ -105,8 +118,6 @@ protected:
             file_helper_.open(filename, truncate_);
             rotation_tp_ = next_rotation_tp_();
         }
-        memory_buf_t formatted;
-        base_sink<Mutex>::formatter_->format(msg, formatted);      //格式化内容 // 为什么要用基类？这里不能直接访问么？？？
         file_helper_.write(formatted);                                 
 
         // Do the cleaning only at the end because it might throw on failure.
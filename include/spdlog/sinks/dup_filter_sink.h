@@ -6,6 +6,7 @@
 #include "dist_sink.h"
 #include <spdlog/details/null_mutex.h>
 #include <spdlog/details/log_msg.h>
+#include <spdlog/details/fmt_helper.h>
 
 #include <mutex>
 #include <string>
@@ -13,6 +14,7 @@
 
 // Duplicate message removal sink.
 // Skip the message if previous one is identical and less than "max_skip_duration" have passed
+// (the same text and the same structured fields)
 //
 // Example:
 //
@@ -48,11 +50,16 @@ protected:
     std::chrono::microseconds max_skip_duration_;
     log_clock::time_point last_msg_time_;
     std::string last_msg_payload_;
+    std::string last_msg_fields_;
     size_t skip_counter_ = 0;
 
     void sink_it_(const details::log_msg &msg) override
     {
-        bool filtered = filter_(msg);
+        // the fields are compared in their text form
+        memory_buf_t fields;
+        details::fmt_helper::append_fields(msg.fields, msg.fields_n, fields);
+        string_view_t fields_text{fields.data(), fields.size()};
+        bool filtered = filter_(msg, fields_text);
         if (!filtered)
         {
             skip_counter_ += 1;
@@ -73,13 +80,14 @@ protected:
         last_msg_time_ = msg.time;
         skip_counter_ = 0;
         last_msg_payload_.assign(msg.payload.data(), msg.payload.data() + msg.payload.size());
+        last_msg_fields_.assign(fields_text.data(), fields_text.data() + fields_text.size());
     }
 
     // return whether the log msg should be displayed (true) or skipped (false)
-    bool filter_(const details::log_msg &msg)
+    bool filter_(const details::log_msg &msg, string_view_t fields_text)
     {
         auto filter_duration = msg.time - last_msg_time_;
-        return (filter_duration > max_skip_duration_) || (msg.payload != last_msg_payload_);
+        return (filter_duration > max_skip_duration_) || (msg.payload != last_msg_payload_) || (fields_text != last_msg_fields_);
     }
 };
 
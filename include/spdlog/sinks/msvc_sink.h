@@ -29,7 +29,8 @@ public:
 protected:
     void sink_it_(const details::log_msg &msg) override
     {
-        memory_buf_t formatted;
+        details::scratch_buffer scratch;
+        memory_buf_t &formatted = scratch.get();
         base_sink<Mutex>::formatter_->format(msg, formatted);
         OutputDebugStringA(fmt::to_string(formatted).c_str());
     }
@@ -25,8 +25,19 @@ public:
 protected:
     void sink_it_(const details::log_msg &msg) override
     {
-        memory_buf_t formatted;
+        details::scratch_buffer scratch;
+        memory_buf_t &formatted = scratch.get();
         base_sink<Mutex>::formatter_->format(msg, formatted);
+        sink_formatted_(msg, formatted);
+    }
+
+    bool writes_formatted_() const override
+    {
+        return true;
+    }
+
+    void sink_formatted_(const details::log_msg &, const memory_buf_t &formatted) override
+    {
         ostream_.write(formatted.data(), static_cast<std::streamsize>(formatted.size()));
         if (force_flush_)
         {
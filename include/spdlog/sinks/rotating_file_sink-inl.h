@@ -63,8 +63,21 @@ SPDLOG_INLINE filename_t rotating_file_sink<Mutex>::filename()
 template<typename Mutex>
 SPDLOG_INLINE void rotating_file_sink<Mutex>::sink_it_(const details::log_msg &msg)
 {
-    memory_buf_t formatted;
+    details::scratch_buffer scratch;
+    memory_buf_t &formatted = scratch.get();
     base_sink<Mutex>::formatter_->format(msg, formatted);
+    sink_formatted_(msg, formatted);
+}
+
+template<typename Mutex>
+SPDLOG_INLINE bool rotating_file_sink<Mutex>::writes_formatted_() const
+{
+    return true;
+}
+
+template<typename Mutex>
+SPDLOG_INLINE void rotating_file_sink<Mutex>::sink_formatted_(const details::log_msg &, const memory_buf_t &formatted)
+{
     current_size_ += formatted.size();
     if (current_size_ > max_size_)
     {
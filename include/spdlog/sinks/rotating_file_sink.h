@@ -28,6 +28,8 @@ public:
 
 protected:
     void sink_it_(const details::log_msg &msg) override;
+    bool writes_formatted_() const override;
+    void sink_formatted_(const details::log_msg &msg, const memory_buf_t &formatted) override;
     void flush_() override;
 
 private:
@@ -14,6 +14,30 @@ SPDLOG_INLINE bool spdlog::sinks::sink::should_log(spdlog::level::level_enum msg
     return msg_level >= level_.load(std::memory_order_relaxed);
 }
 
+SPDLOG_INLINE void spdlog::sinks::sink::log_batch(const details::log_msg *msgs, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        log(msgs[i]);
+    }
+}
+
+SPDLOG_INLINE size_t spdlog::sinks::sink::formatter_id() const
+{
+    return 0;
+}
+
+SPDLOG_INLINE size_t spdlog::sinks::sink::format_and_log(const details::log_msg &msg, memory_buf_t &)
+{
+    log(msg);
+    return 0;
+}
+
+SPDLOG_INLINE void spdlog::sinks::sink::log_formatted(const details::log_msg &msg, const memory_buf_t &, size_t)
+{
+    log(msg);
+}
+
 SPDLOG_INLINE void spdlog::sinks::sink::set_level(level::level_enum log_level)
 {
     level_.store(log_level, std::memory_order_relaxed);
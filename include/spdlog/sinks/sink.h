@@ -14,10 +14,23 @@ class SPDLOG_API sink           // 下沉接口定义 不带锁
 public:
     virtual ~sink() = default;  // = default 以将该函数声明为显示默认构造函数。这就使得编译器为显示默认函数生成了默认实现
     virtual void log(const details::log_msg &msg) = 0; // =0 通知编译系统: “在这里声明一个虚函数，留待派生类中定义”
+    // log count messages at once (used by the async thread pool). default is to log them one by one.
+    virtual void log_batch(const details::log_msg *msgs, size_t count);
     virtual void flush() = 0;
     virtual void set_pattern(const std::string &pattern) = 0;
     virtual void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) = 0;
 
+    // format once, write many.
+    // a sink that can write a message formatted by another sink returns the format_id() of
+    // its formatter (0 otherwise - the default). the logger formats each message once for
+    // all its sinks of the same id, by format() of one of them, and passes the result to
+    // log_formatted() of each. format_and_log() formats into dest and writes it under one
+    // lock, and returns the id it formatted by (0 if dest was not formatted).
+    // log_formatted() formats the message itself if its id changed meanwhile.
+    virtual size_t formatter_id() const;
+    virtual size_t format_and_log(const details::log_msg &msg, memory_buf_t &dest);
+    virtual void log_formatted(const details::log_msg &msg, const memory_buf_t &formatted, size_t format_id);
+
     void set_level(level::level_enum log_level);
     level::level_enum level() const;
     bool should_log(level::level_enum msg_level) const;
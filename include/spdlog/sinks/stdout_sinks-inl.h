@@ -29,6 +29,7 @@ SPDLOG_INLINE stdout_sink_base<ConsoleMutex>::stdout_sink_base(FILE *file)
     : mutex_(ConsoleMutex::mutex())
     , file_(file)
     , formatter_(details::make_unique<spdlog::pattern_formatter>())
+    , formatter_id_(formatter_->format_id())
 {
 #ifdef _WIN32
     // get windows handle from the FILE* object
@@ -53,9 +54,62 @@ SPDLOG_INLINE void stdout_sink_base<ConsoleMutex>::log(const details::log_msg &m
     {        
         return;
     }
+#endif // WIN32
     std::lock_guard<mutex_t> lock(mutex_);
-    memory_buf_t formatted;
+    details::scratch_buffer scratch;
+    memory_buf_t &formatted = scratch.get();
     formatter_->format(msg, formatted);
+    write_(formatted);
+}
+
+template<typename ConsoleMutex>
+SPDLOG_INLINE size_t stdout_sink_base<ConsoleMutex>::formatter_id() const
+{
+    return formatter_id_.load(std::memory_order_relaxed);
+}
+
+template<typename ConsoleMutex>
+SPDLOG_INLINE size_t stdout_sink_base<ConsoleMutex>::format_and_log(const details::log_msg &msg, memory_buf_t &dest)
+{
+    std::lock_guard<mutex_t> lock(mutex_);
+    msg.color_range_start = 0;
+    msg.color_range_end = 0;
+    formatter_->format(msg, dest);
+#ifdef _WIN32
+    if (handle_ != INVALID_HANDLE_VALUE)
+#endif // WIN32
+    {
+        write_(dest);
+    }
+    return formatter_id_.load(std::memory_order_relaxed);
+}
+
+template<typename ConsoleMutex>
+SPDLOG_INLINE void stdout_sink_base<ConsoleMutex>::log_formatted(const details::log_msg &msg, const memory_buf_t &formatted, size_t format_id)
+{
+#ifdef _WIN32
+    if (handle_ == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+#endif // WIN32
+    std::lock_guard<mutex_t> lock(mutex_);
+    if (format_id != 0 && format_id == formatter_id_.load(std::memory_order_relaxed))
+    {
+        write_(formatted);
+        return;
+    }
+    details::scratch_buffer scratch;
+    memory_buf_t &own_formatted = scratch.get();
+    formatter_->format(msg, own_formatted);
+    write_(own_formatted);
+}
+
+// called with the mutex held
+template<typename ConsoleMutex>
+SPDLOG_INLINE void stdout_sink_base<ConsoleMutex>::write_(const memory_buf_t &formatted)
+{
+#ifdef _WIN32
     ::fflush(file_); // flush in case there is somthing in this file_ already
     auto size = static_cast<DWORD>(formatted.size());
     DWORD bytes_written = 0;
@@ -65,9 +119,6 @@ SPDLOG_INLINE void stdout_sink_base<ConsoleMutex>::log(const details::log_msg &m
         throw_spdlog_ex("stdout_sink_base: WriteFile() failed. GetLastError(): " + std::to_string(::GetLastError()));
     }
 #else
-    std::lock_guard<mutex_t> lock(mutex_);
-    memory_buf_t formatted;
-    formatter_->format(msg, formatted);
     ::fwrite(formatted.data(), sizeof(char), formatted.size(), file_);
     ::fflush(file_); // flush every line to terminal
 #endif // WIN32    
@@ -85,6 +136,7 @@ SPDLOG_INLINE void stdout_sink_base<ConsoleMutex>::set_pattern(const std::string
 {
     std::lock_guard<mutex_t> lock(mutex_);
     formatter_ = std::unique_ptr<spdlog::formatter>(new pattern_formatter(pattern));
+    formatter_id_.store(formatter_->format_id(), std::memory_order_relaxed);
 }
 
 template<typename ConsoleMutex>
@@ -92,6 +144,7 @@ SPDLOG_INLINE void stdout_sink_base<ConsoleMutex>::set_formatter(std::unique_ptr
 {
     std::lock_guard<mutex_t> lock(mutex_);
     formatter_ = std::move(sink_formatter);
+    formatter_id_.store(formatter_ ? formatter_->format_id() : 0, std::memory_order_relaxed);
 }
 
 // stdout sink
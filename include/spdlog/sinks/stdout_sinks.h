@@ -4,6 +4,7 @@
 #pragma once
 
 #include <spdlog/details/console_globals.h>
+#include <spdlog/details/scratch_buffer.h>
 #include <spdlog/details/synchronous_factory.h>
 #include <spdlog/sinks/sink.h>
 #include <cstdio>
@@ -36,10 +37,17 @@ public:
 
     void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override;
 
+    size_t formatter_id() const override;
+    size_t format_and_log(const details::log_msg &msg, memory_buf_t &dest) override;
+    void log_formatted(const details::log_msg &msg, const memory_buf_t &formatted, size_t format_id) override;
+
 protected:
     mutex_t &mutex_;
     FILE *file_;
     std::unique_ptr<spdlog::formatter> formatter_;
+    std::atomic<size_t> formatter_id_;
+
+    void write_(const memory_buf_t &formatted);
 #ifdef _WIN32
     HANDLE handle_;    
 #endif // WIN32
@@ -5,6 +5,7 @@
 
 #include <spdlog/sinks/base_sink.h>
 #include <spdlog/details/null_mutex.h>
+#include <spdlog/details/fmt_helper.h>
 #include <spdlog/details/synchronous_factory.h>
 
 #include <array>
@@ -48,16 +49,23 @@ protected:
     void sink_it_(const details::log_msg &msg) override
     {
         string_view_t payload;
-        memory_buf_t formatted;
+        details::scratch_buffer scratch;
+        memory_buf_t &formatted = scratch.get();
         if (enable_formatting_)
         {
             base_sink<Mutex>::formatter_->format(msg, formatted);
             payload = string_view_t(formatted.data(), formatted.size());
         }
-        else
+        else if (msg.fields_n == 0)
         {
             payload = msg.payload;
         }
+        else
+        {
+            details::fmt_helper::append_string_view(msg.payload, formatted);
+            details::fmt_helper::append_fields(msg.fields, msg.fields_n, formatted);
+            payload = string_view_t(formatted.data(), formatted.size());
+        }
 
         size_t length = payload.size();
         // limit to max int
@@ -6,8 +6,11 @@
 #include <spdlog/sinks/base_sink.h>
 #include <spdlog/details/null_mutex.h>
 #include <spdlog/details/synchronous_factory.h>
+#include <spdlog/details/fmt_helper.h>
 
 #include <array>
+#include <string>
+#include <vector>
 #ifndef SD_JOURNAL_SUPPRESS_LOCATION
 #define SD_JOURNAL_SUPPRESS_LOCATION
 #endif
@@ -20,6 +23,8 @@ namespace sinks {
  * Sink that write to systemd journal using the `sd_journal_send()` library call.
  *
  * Locking is not needed, as `sd_journal_send()` itself is thread-safe.
+ * Structured fields (see spdlog::kv()) become journal fields, their keys upper cased
+ * (journal field names are A-Z, 0-9 and '_' only).
  */
 template<typename Mutex>
 class systemd_sink : public base_sink<Mutex>
@@ -56,8 +61,12 @@ protected:
             length = static_cast<size_t>(std::numeric_limits<int>::max());
         }
 
+        if (msg.fields_n > 0)
+        {
+            err = send_with_fields_(msg, length);
+        }
         // Do not send source location if not available
-        if (msg.source.empty())
+        else if (msg.source.empty())
         {
             // Note: function call inside '()' to avoid macro expansion
             err = (sd_journal_send)("MESSAGE=%.*s", static_cast<int>(length), msg.payload.data(), "PRIORITY=%d", syslog_level(msg.level),
@@ -76,6 +85,63 @@ protected:
         }
     }
 
+    // same as above, through sd_journal_sendv() - one entry per journal field
+    int send_with_fields_(const details::log_msg &msg, size_t length)
+    {
+        std::vector<std::string> entries;
+        entries.reserve(6 + msg.fields_n);
+        entries.push_back("MESSAGE=" + std::string(msg.payload.data(), length));
+        entries.push_back("PRIORITY=" + std::to_string(syslog_level(msg.level)));
+        entries.push_back("SYSLOG_IDENTIFIER=" + std::string(msg.logger_name.data(), msg.logger_name.size()));
+        if (!msg.source.empty())
+        {
+            entries.push_back(std::string("CODE_FILE=") + msg.source.filename);
+            entries.push_back("CODE_LINE=" + std::to_string(msg.source.line));
+            entries.push_back(std::string("CODE_FUNC=") + msg.source.funcname);
+        }
+
+        memory_buf_t value;
+        for (size_t i = 0; i < msg.fields_n; i++)
+        {
+            const field &f = msg.fields[i];
+            value.clear();
+            details::fmt_helper::append_field_value(f, value);
+            entries.push_back(journal_field_name_(f.key) + '=' + std::string(value.data(), value.size()));
+        }
+
+        std::vector<struct iovec> iov(entries.size());
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            iov[i].iov_base = const_cast<char *>(entries[i].data());
+            iov[i].iov_len = entries[i].size();
+        }
+        return (sd_journal_sendv)(iov.data(), static_cast<int>(iov.size()));
+    }
+
+    // upper case, other characters to '_'. names starting with '_' are reserved for
+    // the journal itself, and may not start with a digit.
+    static std::string journal_field_name_(string_view_t key)
+    {
+        std::string name;
+        if (key.size() == 0 || key[0] == '_' || (key[0] >= '0' && key[0] <= '9'))
+        {
+            name = "F";
+        }
+        for (auto ch : key)
+        {
+            if (ch >= 'a' && ch <= 'z')
+            {
+                ch = static_cast<char>(ch - 'a' + 'A');
+            }
+            else if (!(ch >= 'A' && ch <= 'Z') && !(ch >= '0' && ch <= '9'))
+            {
+                ch = '_';
+            }
+            name.push_back(ch);
+        }
+        return name;
+    }
+
     int syslog_level(level::level_enum l)
     {
         return syslog_levels_.at(static_cast<levels_array::size_type>(l));
@@ -60,7 +60,8 @@ public:
 protected:
     void sink_it_(const spdlog::details::log_msg &msg) override
     {
-        spdlog::memory_buf_t formatted;
+        spdlog::details::scratch_buffer scratch;
+        spdlog::memory_buf_t &formatted = scratch.get();
         spdlog::sinks::base_sink<Mutex>::formatter_->format(msg, formatted);
         if (!client_.is_connected())
         {
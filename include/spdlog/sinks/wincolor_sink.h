@@ -6,6 +6,7 @@
 #include <spdlog/common.h>
 #include <spdlog/details/console_globals.h>
 #include <spdlog/details/null_mutex.h>
+#include <spdlog/details/scratch_buffer.h>
 #include <spdlog/sinks/sink.h>
 
 #include <memory>
@@ -10,6 +10,8 @@
 #pragma once
 
 #include <spdlog/common.h>
+#include <spdlog/details/callsite.h>
+#include <spdlog/details/rate_limiter.h>
 #include <spdlog/details/registry.h>
 #include <spdlog/logger.h>
 #include <spdlog/version.h>
@@ -111,7 +113,7 @@ SPDLOG_API void set_automatic_registration(bool automatic_registration);
 //
 // The default logger object can be accessed using the spdlog::default_logger():
 // For example, to add another sink to it:
-// spdlog::default_logger()->sinks().push_back(some_sink);
+// spdlog::default_logger()->add_sink(some_sink);
 //
 // The default logger can replaced using spdlog::set_default_logger(new_logger).
 // For example, to replace it with a file logger.
@@ -238,54 +240,244 @@ inline void critical(const T &msg)
 // SPDLOG_LEVEL_OFF
 //
 
-#define SPDLOG_LOGGER_CALL(logger, level, ...) (logger)->log(spdlog::source_loc{__FILE__, __LINE__, SPDLOG_FUNCTION}, level, __VA_ARGS__)
+// the arguments are evaluated only if the logger logs (or backtraces) the level.
+// the statements are expressions (of type void, like the disabled ones): a lambda called in
+// place owns the static callsite (see details/callsite.h) that keeps the file and line.
+// the function name is taken outside the lambda, so it is not the lambda's one.
+// before C++20 a lambda cannot capture a structured binding, so one may not be passed as an
+// argument (some compilers accept it anyway) - copy it to a variable first.
+#define SPDLOG_LOGGER_CALL(logger, level, ...)                                                                                             \
+    [&](const char *spdlog_function_) {                                                                                                    \
+        static const spdlog::details::callsite spdlog_callsite_{__FILE__, __LINE__};                                                       \
+        auto &&spdlog_logger_ = (logger);                                                                                                  \
+        if (spdlog_logger_->should_log(level) || spdlog_logger_->should_backtrace())                                                       \
+        {                                                                                                                                  \
+            spdlog_logger_->log(spdlog_callsite_.loc(spdlog_function_), level, __VA_ARGS__);                                               \
+        }                                                                                                                                  \
+    }(SPDLOG_FUNCTION)
+
+// same, for the default logger. the callsite also caches whether the default logger handles
+// the level - the default logger is only looked up if the statement is enabled.
+#define SPDLOG_DEFAULT_LOGGER_CALL(level, ...)                                                                                             \
+    [&](const char *spdlog_function_) {                                                                                                    \
+        static spdlog::details::callsite spdlog_callsite_{__FILE__, __LINE__};                                                             \
+        if (spdlog_callsite_.enabled(level))                                                                                               \
+        {                                                                                                                                  \
+            spdlog::default_logger_raw()->log(spdlog_callsite_.loc(spdlog_function_), level, __VA_ARGS__);                                 \
+        }                                                                                                                                  \
+    }(SPDLOG_FUNCTION)
+
+// sampled and rate limited statements. each keeps a static limiter (see details/rate_limiter.h),
+// checked after the level and before the arguments are evaluated. when a message passes, the
+// number of messages suppressed before it is noted at its end. expressions, like the above.
+#define SPDLOG_LOGGER_CALL_LIMITED_(logger, level, limiter_type, limiter_args, ...)                                                        \
+    [&](const char *spdlog_function_) {                                                                                                    \
+        static const spdlog::details::callsite spdlog_callsite_{__FILE__, __LINE__};                                                       \
+        auto &&spdlog_logger_ = (logger);                                                                                                  \
+        if (spdlog_logger_->should_log(level) || spdlog_logger_->should_backtrace())                                                       \
+        {                                                                                                                                  \
+            static limiter_type spdlog_limiter_ limiter_args;                                                                              \
+            size_t spdlog_suppressed_ = 0;                                                                                                 \
+            if (spdlog_limiter_.pass(spdlog_suppressed_))                                                                                  \
+            {                                                                                                                              \
+                spdlog_logger_->log_suppressed(spdlog_suppressed_, spdlog_callsite_.loc(spdlog_function_), level, __VA_ARGS__);            \
+            }                                                                                                                              \
+        }                                                                                                                                  \
+    }(SPDLOG_FUNCTION)
+
+#define SPDLOG_DEFAULT_LOGGER_CALL_LIMITED_(level, limiter_type, limiter_args, ...)                                                        \
+    [&](const char *spdlog_function_) {                                                                                                    \
+        static spdlog::details::callsite spdlog_callsite_{__FILE__, __LINE__};                                                             \
+        if (spdlog_callsite_.enabled(level))                                                                                               \
+        {                                                                                                                                  \
+            static limiter_type spdlog_limiter_ limiter_args;                                                                              \
+            size_t spdlog_suppressed_ = 0;                                                                                                 \
+            if (spdlog_limiter_.pass(spdlog_suppressed_))                                                                                  \
+            {                                                                                                                              \
+                spdlog::default_logger_raw()->log_suppressed(                                                                              \
+                    spdlog_suppressed_, spdlog_callsite_.loc(spdlog_function_), level, __VA_ARGS__);                                       \
+            }                                                                                                                              \
+        }                                                                                                                                  \
+    }(SPDLOG_FUNCTION)
+
+// log the 1st, (n+1)th, (2n+1)th.. time
+#define SPDLOG_LOGGER_CALL_EVERY_N(logger, level, n, ...)                                                                                  \
+    SPDLOG_LOGGER_CALL_LIMITED_(logger, level, spdlog::details::every_n_limiter, (n), __VA_ARGS__)
+#define SPDLOG_DEFAULT_LOGGER_CALL_EVERY_N(level, n, ...)                                                                                  \
+    SPDLOG_DEFAULT_LOGGER_CALL_LIMITED_(level, spdlog::details::every_n_limiter, (n), __VA_ARGS__)
+
+// log the first n times only
+#define SPDLOG_LOGGER_CALL_FIRST_N(logger, level, n, ...)                                                                                  \
+    SPDLOG_LOGGER_CALL_LIMITED_(logger, level, spdlog::details::first_n_limiter, (n), __VA_ARGS__)
+#define SPDLOG_DEFAULT_LOGGER_CALL_FIRST_N(level, n, ...)                                                                                  \
+    SPDLOG_DEFAULT_LOGGER_CALL_LIMITED_(level, spdlog::details::first_n_limiter, (n), __VA_ARGS__)
+
+// log at most once every ms milliseconds
+#define SPDLOG_LOGGER_CALL_EVERY_MS(logger, level, ms, ...)                                                                                \
+    SPDLOG_LOGGER_CALL_LIMITED_(logger, level, spdlog::details::every_ms_limiter, (ms), __VA_ARGS__)
+#define SPDLOG_DEFAULT_LOGGER_CALL_EVERY_MS(level, ms, ...)                                                                                \
+    SPDLOG_DEFAULT_LOGGER_CALL_LIMITED_(level, spdlog::details::every_ms_limiter, (ms), __VA_ARGS__)
+
+// log at most per_second times a second on average, in bursts of up to burst messages
+#define SPDLOG_LOGGER_CALL_RATE_LIMITED(logger, level, per_second, burst, ...)                                                             \
+    SPDLOG_LOGGER_CALL_LIMITED_(logger, level, spdlog::details::token_bucket_limiter, (per_second, burst), __VA_ARGS__)
+#define SPDLOG_DEFAULT_LOGGER_CALL_RATE_LIMITED(level, per_second, burst, ...)                                                             \
+    SPDLOG_DEFAULT_LOGGER_CALL_LIMITED_(level, spdlog::details::token_bucket_limiter, (per_second, burst), __VA_ARGS__)
 
 #if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_TRACE
 #define SPDLOG_LOGGER_TRACE(logger, ...) SPDLOG_LOGGER_CALL(logger, spdlog::level::trace, __VA_ARGS__)
-#define SPDLOG_TRACE(...) SPDLOG_LOGGER_TRACE(spdlog::default_logger_raw(), __VA_ARGS__)
+#define SPDLOG_TRACE(...) SPDLOG_DEFAULT_LOGGER_CALL(spdlog::level::trace, __VA_ARGS__)
+#define SPDLOG_LOGGER_TRACE_EVERY_N(logger, n, ...) SPDLOG_LOGGER_CALL_EVERY_N(logger, spdlog::level::trace, n, __VA_ARGS__)
+#define SPDLOG_TRACE_EVERY_N(n, ...) SPDLOG_DEFAULT_LOGGER_CALL_EVERY_N(spdlog::level::trace, n, __VA_ARGS__)
+#define SPDLOG_LOGGER_TRACE_FIRST_N(logger, n, ...) SPDLOG_LOGGER_CALL_FIRST_N(logger, spdlog::level::trace, n, __VA_ARGS__)
+#define SPDLOG_TRACE_FIRST_N(n, ...) SPDLOG_DEFAULT_LOGGER_CALL_FIRST_N(spdlog::level::trace, n, __VA_ARGS__)
+#define SPDLOG_LOGGER_TRACE_EVERY_MS(logger, ms, ...) SPDLOG_LOGGER_CALL_EVERY_MS(logger, spdlog::level::trace, ms, __VA_ARGS__)
+#define SPDLOG_TRACE_EVERY_MS(ms, ...) SPDLOG_DEFAULT_LOGGER_CALL_EVERY_MS(spdlog::level::trace, ms, __VA_ARGS__)
+#define SPDLOG_LOGGER_TRACE_RATE_LIMITED(logger, per_second, burst, ...)                                                                   \
+    SPDLOG_LOGGER_CALL_RATE_LIMITED(logger, spdlog::level::trace, per_second, burst, __VA_ARGS__)
+#define SPDLOG_TRACE_RATE_LIMITED(per_second, burst, ...)                                                                                  \
+    SPDLOG_DEFAULT_LOGGER_CALL_RATE_LIMITED(spdlog::level::trace, per_second, burst, __VA_ARGS__)
 #else
 #define SPDLOG_LOGGER_TRACE(logger, ...) (void)0
 #define SPDLOG_TRACE(...) (void)0
+#define SPDLOG_LOGGER_TRACE_EVERY_N(logger, n, ...) (void)0
+#define SPDLOG_TRACE_EVERY_N(n, ...) (void)0
+#define SPDLOG_LOGGER_TRACE_FIRST_N(logger, n, ...) (void)0
+#define SPDLOG_TRACE_FIRST_N(n, ...) (void)0
+#define SPDLOG_LOGGER_TRACE_EVERY_MS(logger, ms, ...) (void)0
+#define SPDLOG_TRACE_EVERY_MS(ms, ...) (void)0
+#define SPDLOG_LOGGER_TRACE_RATE_LIMITED(logger, per_second, burst, ...) (void)0
+#define SPDLOG_TRACE_RATE_LIMITED(per_second, burst, ...) (void)0
 #endif
 
 #if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG
 #define SPDLOG_LOGGER_DEBUG(logger, ...) SPDLOG_LOGGER_CALL(logger, spdlog::level::debug, __VA_ARGS__)
-#define SPDLOG_DEBUG(...) SPDLOG_LOGGER_DEBUG(spdlog::default_logger_raw(), __VA_ARGS__)
+#define SPDLOG_DEBUG(...) SPDLOG_DEFAULT_LOGGER_CALL(spdlog::level::debug, __VA_ARGS__)
+#define SPDLOG_LOGGER_DEBUG_EVERY_N(logger, n, ...) SPDLOG_LOGGER_CALL_EVERY_N(logger, spdlog::level::debug, n, __VA_ARGS__)
+#define SPDLOG_DEBUG_EVERY_N(n, ...) SPDLOG_DEFAULT_LOGGER_CALL_EVERY_N(spdlog::level::debug, n, __VA_ARGS__)
+#define SPDLOG_LOGGER_DEBUG_FIRST_N(logger, n, ...) SPDLOG_LOGGER_CALL_FIRST_N(logger, spdlog::level::debug, n, __VA_ARGS__)
+#define SPDLOG_DEBUG_FIRST_N(n, ...) SPDLOG_DEFAULT_LOGGER_CALL_FIRST_N(spdlog::level::debug, n, __VA_ARGS__)
+#define SPDLOG_LOGGER_DEBUG_EVERY_MS(logger, ms, ...) SPDLOG_LOGGER_CALL_EVERY_MS(logger, spdlog::level::debug, ms, __VA_ARGS__)
+#define SPDLOG_DEBUG_EVERY_MS(ms, ...) SPDLOG_DEFAULT_LOGGER_CALL_EVERY_MS(spdlog::level::debug, ms, __VA_ARGS__)
+#define SPDLOG_LOGGER_DEBUG_RATE_LIMITED(logger, per_second, burst, ...)                                                                   \
+    SPDLOG_LOGGER_CALL_RATE_LIMITED(logger, spdlog::level::debug, per_second, burst, __VA_ARGS__)
+#define SPDLOG_DEBUG_RATE_LIMITED(per_second, burst, ...)                                                                                  \
+    SPDLOG_DEFAULT_LOGGER_CALL_RATE_LIMITED(spdlog::level::debug, per_second, burst, __VA_ARGS__)
 #else
 #define SPDLOG_LOGGER_DEBUG(logger, ...) (void)0
 #define SPDLOG_DEBUG(...) (void)0
+#define SPDLOG_LOGGER_DEBUG_EVERY_N(logger, n, ...) (void)0
+#define SPDLOG_DEBUG_EVERY_N(n, ...) (void)0
+#define SPDLOG_LOGGER_DEBUG_FIRST_N(logger, n, ...) (void)0
+#define SPDLOG_DEBUG_FIRST_N(n, ...) (void)0
+#define SPDLOG_LOGGER_DEBUG_EVERY_MS(logger, ms, ...) (void)0
+#define SPDLOG_DEBUG_EVERY_MS(ms, ...) (void)0
+#define SPDLOG_LOGGER_DEBUG_RATE_LIMITED(logger, per_second, burst, ...) (void)0
+#define SPDLOG_DEBUG_RATE_LIMITED(per_second, burst, ...) (void)0
 #endif
 
 #if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_INFO
 #define SPDLOG_LOGGER_INFO(logger, ...) SPDLOG_LOGGER_CALL(logger, spdlog::level::info, __VA_ARGS__)
-#define SPDLOG_INFO(...) SPDLOG_LOGGER_INFO(spdlog::default_logger_raw(), __VA_ARGS__)
+#define SPDLOG_INFO(...) SPDLOG_DEFAULT_LOGGER_CALL(spdlog::level::info, __VA_ARGS__)
+#define SPDLOG_LOGGER_INFO_EVERY_N(logger, n, ...) SPDLOG_LOGGER_CALL_EVERY_N(logger, spdlog::level::info, n, __VA_ARGS__)
+#define SPDLOG_INFO_EVERY_N(n, ...) SPDLOG_DEFAULT_LOGGER_CALL_EVERY_N(spdlog::level::info, n, __VA_ARGS__)
+#define SPDLOG_LOGGER_INFO_FIRST_N(logger, n, ...) SPDLOG_LOGGER_CALL_FIRST_N(logger, spdlog::level::info, n, __VA_ARGS__)
+#define SPDLOG_INFO_FIRST_N(n, ...) SPDLOG_DEFAULT_LOGGER_CALL_FIRST_N(spdlog::level::info, n, __VA_ARGS__)
+#define SPDLOG_LOGGER_INFO_EVERY_MS(logger, ms, ...) SPDLOG_LOGGER_CALL_EVERY_MS(logger, spdlog::level::info, ms, __VA_ARGS__)
+#define SPDLOG_INFO_EVERY_MS(ms, ...) SPDLOG_DEFAULT_LOGGER_CALL_EVERY_MS(spdlog::level::info, ms, __VA_ARGS__)
+#define SPDLOG_LOGGER_INFO_RATE_LIMITED(logger, per_second, burst, ...)                                                                    \
+    SPDLOG_LOGGER_CALL_RATE_LIMITED(logger, spdlog::level::info, per_second, burst, __VA_ARGS__)
+#define SPDLOG_INFO_RATE_LIMITED(per_second, burst, ...)                                                                                   \
+    SPDLOG_DEFAULT_LOGGER_CALL_RATE_LIMITED(spdlog::level::info, per_second, burst, __VA_ARGS__)
 #else
 #define SPDLOG_LOGGER_INFO(logger, ...) (void)0
 #define SPDLOG_INFO(...) (void)0
+#define SPDLOG_LOGGER_INFO_EVERY_N(logger, n, ...) (void)0
+#define SPDLOG_INFO_EVERY_N(n, ...) (void)0
+#define SPDLOG_LOGGER_INFO_FIRST_N(logger, n, ...) (void)0
+#define SPDLOG_INFO_FIRST_N(n, ...) (void)0
+#define SPDLOG_LOGGER_INFO_EVERY_MS(logger, ms, ...) (void)0
+#define SPDLOG_INFO_EVERY_MS(ms, ...) (void)0
+#define SPDLOG_LOGGER_INFO_RATE_LIMITED(logger, per_second, burst, ...) (void)0
+#define SPDLOG_INFO_RATE_LIMITED(per_second, burst, ...) (void)0
 #endif
 
 #if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_WARN
 #define SPDLOG_LOGGER_WARN(logger, ...) SPDLOG_LOGGER_CALL(logger, spdlog::level::warn, __VA_ARGS__)
-#define SPDLOG_WARN(...) SPDLOG_LOGGER_WARN(spdlog::default_logger_raw(), __VA_ARGS__)
+#define SPDLOG_WARN(...) SPDLOG_DEFAULT_LOGGER_CALL(spdlog::level::warn, __VA_ARGS__)
+#define SPDLOG_LOGGER_WARN_EVERY_N(logger, n, ...) SPDLOG_LOGGER_CALL_EVERY_N(logger, spdlog::level::warn, n, __VA_ARGS__)
+#define SPDLOG_WARN_EVERY_N(n, ...) SPDLOG_DEFAULT_LOGGER_CALL_EVERY_N(spdlog::level::warn, n, __VA_ARGS__)
+#define SPDLOG_LOGGER_WARN_FIRST_N(logger, n, ...) SPDLOG_LOGGER_CALL_FIRST_N(logger, spdlog::level::warn, n, __VA_ARGS__)
+#define SPDLOG_WARN_FIRST_N(n, ...) SPDLOG_DEFAULT_LOGGER_CALL_FIRST_N(spdlog::level::warn, n, __VA_ARGS__)
+#define SPDLOG_LOGGER_WARN_EVERY_MS(logger, ms, ...) SPDLOG_LOGGER_CALL_EVERY_MS(logger, spdlog::level::warn, ms, __VA_ARGS__)
+#define SPDLOG_WARN_EVERY_MS(ms, ...) SPDLOG_DEFAULT_LOGGER_CALL_EVERY_MS(spdlog::level::warn, ms, __VA_ARGS__)
+#define SPDLOG_LOGGER_WARN_RATE_LIMITED(logger, per_second, burst, ...)                                                                    \
+    SPDLOG_LOGGER_CALL_RATE_LIMITED(logger, spdlog::level::warn, per_second, burst, __VA_ARGS__)
+#define SPDLOG_WARN_RATE_LIMITED(per_second, burst, ...)                                                                                   \
+    SPDLOG_DEFAULT_LOGGER_CALL_RATE_LIMITED(spdlog::level::warn, per_second, burst, __VA_ARGS__)
 #else
 #define SPDLOG_LOGGER_WARN(logger, ...) (void)0
 #define SPDLOG_WARN(...) (void)0
+#define SPDLOG_LOGGER_WARN_EVERY_N(logger, n, ...) (void)0
+#define SPDLOG_WARN_EVERY_N(n, ...) (void)0
+#define SPDLOG_LOGGER_WARN_FIRST_N(logger, n, ...) (void)0
+#define SPDLOG_WARN_FIRST_N(n, ...) (void)0
+#define SPDLOG_LOGGER_WARN_EVERY_MS(logger, ms, ...) (void)0
+#define SPDLOG_WARN_EVERY_MS(ms, ...) (void)0
+#define SPDLOG_LOGGER_WARN_RATE_LIMITED(logger, per_second, burst, ...) (void)0
+#define SPDLOG_WARN_RATE_LIMITED(per_second, burst, ...) (void)0
 #endif
 
 #if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_ERROR
 #define SPDLOG_LOGGER_ERROR(logger, ...) SPDLOG_LOGGER_CALL(logger, spdlog::level::err, __VA_ARGS__)
-#define SPDLOG_ERROR(...) SPDLOG_LOGGER_ERROR(spdlog::default_logger_raw(), __VA_ARGS__)
+#define SPDLOG_ERROR(...) SPDLOG_DEFAULT_LOGGER_CALL(spdlog::level::err, __VA_ARGS__)
+#define SPDLOG_LOGGER_ERROR_EVERY_N(logger, n, ...) SPDLOG_LOGGER_CALL_EVERY_N(logger, spdlog::level::err, n, __VA_ARGS__)
+#define SPDLOG_ERROR_EVERY_N(n, ...) SPDLOG_DEFAULT_LOGGER_CALL_EVERY_N(spdlog::level::err, n, __VA_ARGS__)
+#define SPDLOG_LOGGER_ERROR_FIRST_N(logger, n, ...) SPDLOG_LOGGER_CALL_FIRST_N(logger, spdlog::level::err, n, __VA_ARGS__)
+#define SPDLOG_ERROR_FIRST_N(n, ...) SPDLOG_DEFAULT_LOGGER_CALL_FIRST_N(spdlog::level::err, n, __VA_ARGS__)
+#define SPDLOG_LOGGER_ERROR_EVERY_MS(logger, ms, ...) SPDLOG_LOGGER_CALL_EVERY_MS(logger, spdlog::level::err, ms, __VA_ARGS__)
+#define SPDLOG_ERROR_EVERY_MS(ms, ...) SPDLOG_DEFAULT_LOGGER_CALL_EVERY_MS(spdlog::level::err, ms, __VA_ARGS__)
+#define SPDLOG_LOGGER_ERROR_RATE_LIMITED(logger, per_second, burst, ...)                                                                   \
+    SPDLOG_LOGGER_CALL_RATE_LIMITED(logger, spdlog::level::err, per_second, burst, __VA_ARGS__)
+#define SPDLOG_ERROR_RATE_LIMITED(per_second, burst, ...)                                                                                  \
+    SPDLOG_DEFAULT_LOGGER_CALL_RATE_LIMITED(spdlog::level::err, per_second, burst, __VA_ARGS__)
 #else
 #define SPDLOG_LOGGER_ERROR(logger, ...) (void)0
 #define SPDLOG_ERROR(...) (void)0
+#define SPDLOG_LOGGER_ERROR_EVERY_N(logger, n, ...) (void)0
+#define SPDLOG_ERROR_EVERY_N(n, ...) (void)0
+#define SPDLOG_LOGGER_ERROR_FIRST_N(logger, n, ...) (void)0
+#define SPDLOG_ERROR_FIRST_N(n, ...) (void)0
+#define SPDLOG_LOGGER_ERROR_EVERY_MS(logger, ms, ...) (void)0
+#define SPDLOG_ERROR_EVERY_MS(ms, ...) (void)0
+#define SPDLOG_LOGGER_ERROR_RATE_LIMITED(logger, per_second, burst, ...) (void)0
+#define SPDLOG_ERROR_RATE_LIMITED(per_second, burst, ...) (void)0
 #endif
 
 #if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_CRITICAL
 #define SPDLOG_LOGGER_CRITICAL(logger, ...) SPDLOG_LOGGER_CALL(logger, spdlog::level::critical, __VA_ARGS__)
-#define SPDLOG_CRITICAL(...) SPDLOG_LOGGER_CRITICAL(spdlog::default_logger_raw(), __VA_ARGS__)
+#define SPDLOG_CRITICAL(...) SPDLOG_DEFAULT_LOGGER_CALL(spdlog::level::critical, __VA_ARGS__)
+#define SPDLOG_LOGGER_CRITICAL_EVERY_N(logger, n, ...) SPDLOG_LOGGER_CALL_EVERY_N(logger, spdlog::level::critical, n, __VA_ARGS__)
+#define SPDLOG_CRITICAL_EVERY_N(n, ...) SPDLOG_DEFAULT_LOGGER_CALL_EVERY_N(spdlog::level::critical, n, __VA_ARGS__)
+#define SPDLOG_LOGGER_CRITICAL_FIRST_N(logger, n, ...) SPDLOG_LOGGER_CALL_FIRST_N(logger, spdlog::level::critical, n, __VA_ARGS__)
+#define SPDLOG_CRITICAL_FIRST_N(n, ...) SPDLOG_DEFAULT_LOGGER_CALL_FIRST_N(spdlog::level::critical, n, __VA_ARGS__)
+#define SPDLOG_LOGGER_CRITICAL_EVERY_MS(logger, ms, ...) SPDLOG_LOGGER_CALL_EVERY_MS(logger, spdlog::level::critical, ms, __VA_ARGS__)
+#define SPDLOG_CRITICAL_EVERY_MS(ms, ...) SPDLOG_DEFAULT_LOGGER_CALL_EVERY_MS(spdlog::level::critical, ms, __VA_ARGS__)
+#define SPDLOG_LOGGER_CRITICAL_RATE_LIMITED(logger, per_second, burst, ...)                                                                \
+    SPDLOG_LOGGER_CALL_RATE_LIMITED(logger, spdlog::level::critical, per_second, burst, __VA_ARGS__)
+#define SPDLOG_CRITICAL_RATE_LIMITED(per_second, burst, ...)                                                                               \
+    SPDLOG_DEFAULT_LOGGER_CALL_RATE_LIMITED(spdlog::level::critical, per_second, burst, __VA_ARGS__)
 #else
 #define SPDLOG_LOGGER_CRITICAL(logger, ...) (void)0
 #define SPDLOG_CRITICAL(...) (void)0
+#define SPDLOG_LOGGER_CRITICAL_EVERY_N(logger, n, ...) (void)0
+#define SPDLOG_CRITICAL_EVERY_N(n, ...) (void)0
+#define SPDLOG_LOGGER_CRITICAL_FIRST_N(logger, n, ...) (void)0
+#define SPDLOG_CRITICAL_FIRST_N(n, ...) (void)0
+#define SPDLOG_LOGGER_CRITICAL_EVERY_MS(logger, ms, ...) (void)0
+#define SPDLOG_CRITICAL_EVERY_MS(ms, ...) (void)0
+#define SPDLOG_LOGGER_CRITICAL_RATE_LIMITED(logger, per_second, burst, ...) (void)0
+#define SPDLOG_CRITICAL_RATE_LIMITED(per_second, burst, ...) (void)0
 #endif
 
 #ifdef SPDLOG_HEADER_ONLY
@@ -0,0 +1,630 @@
+// Copyright(c) 2015-present, Gabi Melman & spdlog contributors.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+
+#pragma once
+
+// Pattern formatter whose pattern is parsed at compile time.
+// The pattern is a template argument, so format() is a fixed sequence of inlined
+// appends - no parsing, and no virtual call per flag. The output is the same as
+// pattern_formatter's for the same pattern (and so is format_id()):
+//
+//   using my_formatter = SPDLOG_STATIC_PATTERN("[%Y-%m-%d %H:%M:%S.%e] [%l] %v");
+//   file_sink->set_formatter(spdlog::details::make_unique<my_formatter>());
+//
+// The pattern is passed as a pack of chars (C++11 has no string template arguments),
+// SPDLOG_STATIC_PATTERN() expands a string literal of up to 95 chars into it.
+// Not supported (compile error): padding specs (e.g. %-8l), custom flags and the
+// elapsed time flags (%u %i %o %O).
+
+#include <spdlog/common.h>
+#include <spdlog/details/civil_time.h>
+#include <spdlog/details/fmt_helper.h>
+#include <spdlog/details/log_msg.h>
+#include <spdlog/details/os.h>
+#include <spdlog/formatter.h>
+#include <spdlog/pattern_formatter.h>
+
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <string>
+
+namespace spdlog {
+namespace details {
+namespace static_pattern {
+
+template<char C>
+struct always_false : std::false_type
+{};
+
+// index of the first '%' or '\0' at or after i
+SPDLOG_CONSTEXPR size_t literal_end(const char *s, size_t i)
+{
+    return (s[i] == '%' || s[i] == '\0') ? i : literal_end(s, i + 1);
+}
+
+inline string_view_t day_name(const std::tm &tm_time)
+{
+    static const char *const names[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+    return names[tm_time.tm_wday];
+}
+
+inline string_view_t full_day_name(const std::tm &tm_time)
+{
+    static const char *const names[] = {"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
+    return names[tm_time.tm_wday];
+}
+
+inline string_view_t month_name(const std::tm &tm_time)
+{
+    static const char *const names[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sept", "Oct", "Nov", "Dec"};
+    return names[tm_time.tm_mon];
+}
+
+inline string_view_t full_month_name(const std::tm &tm_time)
+{
+    static const char *const names[] = {
+        "January", "February", "March", "April", "May", "June", "July", "August", "September", "October", "November", "December"};
+    return names[tm_time.tm_mon];
+}
+
+inline int to12h(const std::tm &tm_time)
+{
+    return tm_time.tm_hour > 12 ? tm_time.tm_hour - 12 : tm_time.tm_hour;
+}
+
+inline string_view_t ampm(const std::tm &tm_time)
+{
+    return tm_time.tm_hour >= 12 ? "PM" : "AM";
+}
+
+inline const char *basename(const char *filename)
+{
+    const char *base = filename;
+    for (const char *p = filename; *p != '\0'; p++)
+    {
+        if (std::strchr(os::folder_seps, *p) != nullptr)
+        {
+            base = p + 1;
+        }
+    }
+    return base;
+}
+
+inline void append_hms(const std::tm &tm_time, memory_buf_t &dest)
+{
+    fmt_helper::pad2(tm_time.tm_hour, dest);
+    dest.push_back(':');
+    fmt_helper::pad2(tm_time.tm_min, dest);
+    dest.push_back(':');
+    fmt_helper::pad2(tm_time.tm_sec, dest);
+}
+
+// one flag of the pattern. needs_tm - if it reads the broken down time.
+template<char Flag>
+struct flag
+{
+    static_assert(Flag != '-' && Flag != '=' && (Flag < '0' || Flag > '9'), "static_pattern_formatter: padding is not supported");
+    static_assert(
+        Flag != 'u' && Flag != 'i' && Flag != 'o' && Flag != 'O', "static_pattern_formatter: elapsed time flags are not supported");
+    static const bool needs_tm = false;
+
+    // unknown flags appear as is
+    static void format(const log_msg &, const std::tm &, memory_buf_t &dest)
+    {
+        dest.push_back('%');
+        dest.push_back(Flag);
+    }
+};
+
+#define SPDLOG_STATIC_FLAG_(ch, uses_tm)                                                                                                   \
+    template<>                                                                                                                             \
+    struct flag<ch>                                                                                                                        \
+    {                                                                                                                                      \
+        static const bool needs_tm = uses_tm;                                                                                              \
+        static void format(const log_msg &msg, const std::tm &tm_time, memory_buf_t &dest);                                                \
+    };                                                                                                                                     \
+    inline void flag<ch>::format(const log_msg &msg, const std::tm &tm_time, memory_buf_t &dest)
+
+// logger name
+SPDLOG_STATIC_FLAG_('n', false)
+{
+    (void)tm_time;
+    fmt_helper::append_string_view(msg.logger_name, dest);
+}
+
+// level
+SPDLOG_STATIC_FLAG_('l', false)
+{
+    (void)tm_time;
+    fmt_helper::append_string_view(level::to_string_view(msg.level), dest);
+}
+
+// short level
+SPDLOG_STATIC_FLAG_('L', false)
+{
+    (void)tm_time;
+    fmt_helper::append_string_view(level::to_short_c_str(msg.level), dest);
+}
+
+// thread id
+SPDLOG_STATIC_FLAG_('t', false)
+{
+    (void)tm_time;
+    fmt_helper::append_int(msg.thread_id, dest);
+}
+
+// the message text and its fields
+SPDLOG_STATIC_FLAG_('v', false)
+{
+    (void)tm_time;
+    fmt_helper::append_string_view(msg.payload, dest);
+    fmt_helper::append_fields(msg.fields, msg.fields_n, dest);
+}
+
+// weekday
+SPDLOG_STATIC_FLAG_('a', true)
+{
+    (void)msg;
+    fmt_helper::append_string_view(day_name(tm_time), dest);
+}
+
+SPDLOG_STATIC_FLAG_('A', true)
+{
+    (void)msg;
+    fmt_helper::append_string_view(full_day_name(tm_time), dest);
+}
+
+// month
+SPDLOG_STATIC_FLAG_('b', true)
+{
+    (void)msg;
+    fmt_helper::append_string_view(month_name(tm_time), dest);
+}
+
+SPDLOG_STATIC_FLAG_('h', true)
+{
+    flag<'b'>::format(msg, tm_time, dest);
+}
+
+SPDLOG_STATIC_FLAG_('B', true)
+{
+    (void)msg;
+    fmt_helper::append_string_view(full_month_name(tm_time), dest);
+}
+
+// datetime
+SPDLOG_STATIC_FLAG_('c', true)
+{
+    (void)msg;
+    fmt_helper::append_string_view(day_name(tm_time), dest);
+    dest.push_back(' ');
+    fmt_helper::append_string_view(month_name(tm_time), dest);
+    dest.push_back(' ');
+    fmt_helper::append_int(tm_time.tm_mday, dest);
+    dest.push_back(' ');
+    append_hms(tm_time, dest);
+    dest.push_back(' ');
+    fmt_helper::append_int(tm_time.tm_year + 1900, dest);
+}
+
+// year 2 digits
+SPDLOG_STATIC_FLAG_('C', true)
+{
+    (void)msg;
+    fmt_helper::pad2(tm_time.tm_year % 100, dest);
+}
+
+// year 4 digits
+SPDLOG_STATIC_FLAG_('Y', true)
+{
+    (void)msg;
+    fmt_helper::append_int(tm_time.tm_year + 1900, dest);
+}
+
+// MM/DD/YY
+SPDLOG_STATIC_FLAG_('D', true)
+{
+    (void)msg;
+    fmt_helper::pad2(tm_time.tm_mon + 1, dest);
+    dest.push_back('/');
+    fmt_helper::pad2(tm_time.tm_mday, dest);
+    dest.push_back('/');
+    fmt_helper::pad2(tm_time.tm_year % 100, dest);
+}
+
+SPDLOG_STATIC_FLAG_('x', true)
+{
+    flag<'D'>::format(msg, tm_time, dest);
+}
+
+// month 1-12
+SPDLOG_STATIC_FLAG_('m', true)
+{
+    (void)msg;
+    fmt_helper::pad2(tm_time.tm_mon + 1, dest);
+}
+
+// day of month 1-31
+SPDLOG_STATIC_FLAG_('d', true)
+{
+    (void)msg;
+    fmt_helper::pad2(tm_time.tm_mday, dest);
+}
+
+// hours 24
+SPDLOG_STATIC_FLAG_('H', true)
+{
+    (void)msg;
+    fmt_helper::pad2(tm_time.tm_hour, dest);
+}
+
+// hours 12
+SPDLOG_STATIC_FLAG_('I', true)
+{
+    (void)msg;
+    fmt_helper::pad2(to12h(tm_time), dest);
+}
+
+// minutes
+SPDLOG_STATIC_FLAG_('M', true)
+{
+    (void)msg;
+    fmt_helper::pad2(tm_time.tm_min, dest);
+}
+
+// seconds
+SPDLOG_STATIC_FLAG_('S', true)
+{
+    (void)msg;
+    fmt_helper::pad2(tm_time.tm_sec, dest);
+}
+
+// milliseconds
+SPDLOG_STATIC_FLAG_('e', false)
+{
+    (void)tm_time;
+    auto millis = fmt_helper::time_fraction<std::chrono::milliseconds>(msg.time);
+    fmt_helper::pad3(static_cast<uint32_t>(millis.count()), dest);
+}
+
+// microseconds
+SPDLOG_STATIC_FLAG_('f', false)
+{
+    (void)tm_time;
+    auto micros = fmt_helper::time_fraction<std::chrono::microseconds>(msg.time);
+    fmt_helper::pad6(static_cast<size_t>(micros.count()), dest);
+}
+
+// nanoseconds
+SPDLOG_STATIC_FLAG_('F', false)
+{
+    (void)tm_time;
+    auto ns = fmt_helper::time_fraction<std::chrono::nanoseconds>(msg.time);
+    fmt_helper::pad9(static_cast<size_t>(ns.count()), dest);
+}
+
+// seconds since epoch
+SPDLOG_STATIC_FLAG_('E', false)
+{
+    (void)tm_time;
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(msg.time.time_since_epoch()).count();
+    fmt_helper::append_int(seconds, dest);
+}
+
+// am/pm
+SPDLOG_STATIC_FLAG_('p', true)
+{
+    (void)msg;
+    fmt_helper::append_string_view(ampm(tm_time), dest);
+}
+
+// 12 hour clock 02:55:02 PM
+SPDLOG_STATIC_FLAG_('r', true)
+{
+    (void)msg;
+    fmt_helper::pad2(to12h(tm_time), dest);
+    dest.push_back(':');
+    fmt_helper::pad2(tm_time.tm_min, dest);
+    dest.push_back(':');
+    fmt_helper::pad2(tm_time.tm_sec, dest);
+    dest.push_back(' ');
+    fmt_helper::append_string_view(ampm(tm_time), dest);
+}
+
+// HH:MM
+SPDLOG_STATIC_FLAG_('R', true)
+{
+    (void)msg;
+    fmt_helper::pad2(tm_time.tm_hour, dest);
+    dest.push_back(':');
+    fmt_helper::pad2(tm_time.tm_min, dest);
+}
+
+// HH:MM:SS
+SPDLOG_STATIC_FLAG_('T', true)
+{
+    (void)msg;
+    append_hms(tm_time, dest);
+}
+
+SPDLOG_STATIC_FLAG_('X', true)
+{
+    flag<'T'>::format(msg, tm_time, dest);
+}
+
+// timezone
+SPDLOG_STATIC_FLAG_('z', true)
+{
+    (void)msg;
+    auto total_minutes = os::utc_minutes_offset(tm_time);
+    if (total_minutes < 0)
+    {
+        total_minutes = -total_minutes;
+        dest.push_back('-');
+    }
+    else
+    {
+        dest.push_back('+');
+    }
+    fmt_helper::pad2(total_minutes / 60, dest);
+    dest.push_back(':');
+    fmt_helper::pad2(total_minutes % 60, dest);
+}
+
+// pid
+SPDLOG_STATIC_FLAG_('P', false)
+{
+    (void)msg;
+    (void)tm_time;
+    fmt_helper::append_int(static_cast<uint32_t>(os::pid()), dest);
+}
+
+// color range
+SPDLOG_STATIC_FLAG_('^', false)
+{
+    (void)tm_time;
+    msg.color_range_start = dest.size();
+}
+
+SPDLOG_STATIC_FLAG_('$', false)
+{
+    (void)tm_time;
+    msg.color_range_end = dest.size();
+}
+
+// source location (filename:line)
+SPDLOG_STATIC_FLAG_('@', false)
+{
+    (void)tm_time;
+    if (!msg.source.empty())
+    {
+        fmt_helper::append_string_view(msg.source.filename, dest);
+        dest.push_back(':');
+        fmt_helper::append_int(msg.source.line, dest);
+    }
+}
+
+// short source filename
+SPDLOG_STATIC_FLAG_('s', false)
+{
+    (void)tm_time;
+    if (!msg.source.empty())
+    {
+        fmt_helper::append_string_view(basename(msg.source.filename), dest);
+    }
+}
+
+// full source filename
+SPDLOG_STATIC_FLAG_('g', false)
+{
+    (void)tm_time;
+    if (!msg.source.empty())
+    {
+        fmt_helper::append_string_view(msg.source.filename, dest);
+    }
+}
+
+// source line
+SPDLOG_STATIC_FLAG_('#', false)
+{
+    (void)tm_time;
+    if (!msg.source.empty())
+    {
+        fmt_helper::append_int(msg.source.line, dest);
+    }
+}
+
+// source funcname
+SPDLOG_STATIC_FLAG_('!', false)
+{
+    (void)tm_time;
+    if (!msg.source.empty())
+    {
+        fmt_helper::append_string_view(msg.source.funcname, dest);
+    }
+}
+
+SPDLOG_STATIC_FLAG_('%', false)
+{
+    (void)msg;
+    (void)tm_time;
+    dest.push_back('%');
+}
+
+// default format: [2014-10-31 23:46:59.678] [logger] [info] [file:line] message
+SPDLOG_STATIC_FLAG_('+', true)
+{
+    dest.push_back('[');
+    flag<'Y'>::format(msg, tm_time, dest);
+    dest.push_back('-');
+    flag<'m'>::format(msg, tm_time, dest);
+    dest.push_back('-');
+    flag<'d'>::format(msg, tm_time, dest);
+    dest.push_back(' ');
+    append_hms(tm_time, dest);
+    dest.push_back('.');
+    flag<'e'>::format(msg, tm_time, dest);
+    dest.push_back(']');
+    dest.push_back(' ');
+    if (msg.logger_name.size() > 0)
+    {
+        dest.push_back('[');
+        fmt_helper::append_string_view(msg.logger_name, dest);
+        dest.push_back(']');
+        dest.push_back(' ');
+    }
+    dest.push_back('[');
+    msg.color_range_start = dest.size();
+    fmt_helper::append_string_view(level::to_string_view(msg.level), dest);
+    msg.color_range_end = dest.size();
+    dest.push_back(']');
+    dest.push_back(' ');
+    if (!msg.source.empty())
+    {
+        dest.push_back('[');
+        fmt_helper::append_string_view(basename(msg.source.filename), dest);
+        dest.push_back(':');
+        fmt_helper::append_int(msg.source.line, dest);
+        dest.push_back(']');
+        dest.push_back(' ');
+    }
+    flag<'v'>::format(msg, tm_time, dest);
+}
+
+#undef SPDLOG_STATIC_FLAG_
+
+// Formatter if the pattern literal fits in the SPDLOG_STATIC_PATTERN() pack
+template<bool Fits, typename Formatter>
+struct checked_length
+{
+    static_assert(Fits, "SPDLOG_STATIC_PATTERN: the pattern is too long (max 95 chars)");
+    using type = Formatter;
+};
+
+// the chars of the pattern, '\0' terminated
+template<char... Chars>
+struct chars
+{
+    static SPDLOG_CONSTEXPR const char str[sizeof...(Chars) + 1] = {Chars..., '\0'};
+};
+
+template<char... Chars>
+SPDLOG_CONSTEXPR const char chars<Chars...>::str[sizeof...(Chars) + 1];
+
+// the pattern from index I: a run of literal chars, a flag, or the end
+template<typename Pattern, size_t I, char C = Pattern::str[I]>
+struct step
+{
+    static const size_t end = literal_end(Pattern::str, I);
+    using next = step<Pattern, end>;
+    static const bool needs_tm = next::needs_tm;
+
+    static void format(const log_msg &msg, const std::tm &tm_time, memory_buf_t &dest)
+    {
+        dest.append(Pattern::str + I, Pattern::str + end);
+        next::format(msg, tm_time, dest);
+    }
+};
+
+template<typename Pattern, size_t I>
+struct step<Pattern, I, '\0'>
+{
+    static const bool needs_tm = false;
+
+    static void format(const log_msg &, const std::tm &, memory_buf_t &) {}
+};
+
+template<typename Pattern, size_t I>
+struct step<Pattern, I, '%'>
+{
+    static const char flag_char = Pattern::str[I + 1];
+    // a trailing '%' is ignored
+    using next = step<Pattern, flag_char == '\0' ? I + 1 : I + 2>;
+    using this_flag = typename std::conditional<flag_char == '\0', step<Pattern, I + 1>, flag<flag_char>>::type;
+    static const bool needs_tm = this_flag::needs_tm || next::needs_tm;
+
+    static void format(const log_msg &msg, const std::tm &tm_time, memory_buf_t &dest)
+    {
+        this_flag::format(msg, tm_time, dest);
+        next::format(msg, tm_time, dest);
+    }
+};
+
+} // namespace static_pattern
+} // namespace details
+
+template<char... Chars>
+class static_pattern_formatter final : public formatter
+{
+    using pattern_chars = details::static_pattern::chars<Chars...>;
+    using program = details::static_pattern::step<pattern_chars, 0>;
+
+public:
+    explicit static_pattern_formatter(pattern_time_type time_type = pattern_time_type::local, std::string eol = details::os::default_eol)
+        : eol_(std::move(eol))
+        , pattern_time_type_(time_type)
+        , format_id_(pattern_formatter::format_id_of(pattern(), time_type, eol_))
+    {
+        std::memset(&cached_tm_, 0, sizeof(cached_tm_));
+    }
+
+    static_pattern_formatter(const static_pattern_formatter &) = delete;
+    static_pattern_formatter &operator=(const static_pattern_formatter &) = delete;
+
+    static std::string pattern()
+    {
+        return std::string(pattern_chars::str);
+    }
+
+    void format(const details::log_msg &msg, memory_buf_t &dest) override
+    {
+        if (program::needs_tm)
+        {
+            auto secs = std::chrono::duration_cast<std::chrono::seconds>(msg.time.time_since_epoch());
+            if (secs != last_log_secs_)
+            {
+                auto tt = log_clock::to_time_t(msg.time);
+                cached_tm_ = pattern_time_type_ == pattern_time_type::local ? details::civil_time::local(tt) : details::civil_time::utc(tt);
+                last_log_secs_ = secs;
+            }
+        }
+        program::format(msg, cached_tm_, dest);
+        details::fmt_helper::append_string_view(eol_, dest);
+    }
+
+    std::unique_ptr<formatter> clone() const override
+    {
+        return details::make_unique<static_pattern_formatter>(pattern_time_type_, eol_);
+    }
+
+    size_t format_id() const override
+    {
+        return format_id_;
+    }
+
+private:
+    std::string eol_;
+    pattern_time_type pattern_time_type_;
+    size_t format_id_;
+    std::tm cached_tm_;
+    std::chrono::seconds last_log_secs_{0};
+};
+
+} // namespace spdlog
+
+// char i of the string literal s, or '\0' past its end
+#define SPDLOG_PATTERN_CHAR_(s, i) (i < sizeof(s) ? s[i < sizeof(s) ? i : 0] : '\0')
+#define SPDLOG_PATTERN_CHARS_8_(s, i)                                                                                                      \
+    SPDLOG_PATTERN_CHAR_(s, i), SPDLOG_PATTERN_CHAR_(s, i + 1), SPDLOG_PATTERN_CHAR_(s, i + 2), SPDLOG_PATTERN_CHAR_(s, i + 3),            \
+        SPDLOG_PATTERN_CHAR_(s, i + 4), SPDLOG_PATTERN_CHAR_(s, i + 5), SPDLOG_PATTERN_CHAR_(s, i + 6),                                    \
+        SPDLOG_PATTERN_CHAR_(s, i + 7)
+#define SPDLOG_PATTERN_CHARS_32_(s, i)                                                                                                     \
+    SPDLOG_PATTERN_CHARS_8_(s, i), SPDLOG_PATTERN_CHARS_8_(s, i + 8), SPDLOG_PATTERN_CHARS_8_(s, i + 16), SPDLOG_PATTERN_CHARS_8_(s, i + 24)
+
+// the static_pattern_formatter type of the given pattern literal (up to 95 chars)
+#define SPDLOG_STATIC_PATTERN(pattern)                                                                                                     \
+    spdlog::details::static_pattern::checked_length<sizeof(pattern) <= 96,                                                                 \
+        spdlog::static_pattern_formatter<SPDLOG_PATTERN_CHARS_32_(pattern, 0), SPDLOG_PATTERN_CHARS_32_(pattern, 32),                      \
+            SPDLOG_PATTERN_CHARS_32_(pattern, 64)>>::type
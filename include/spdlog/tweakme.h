@@ -38,6 +38,13 @@
 // #define SPDLOG_NO_TLS
 ///////////////////////////////////////////////////////////////////////////////
 
+///////////////////////////////////////////////////////////////////////////////
+// Uncomment to change the size above which the thread local formatting
+// buffers are released after use (see details/scratch_buffer.h).
+//
+// #define SPDLOG_SCRATCH_BUFFER_MAX_SIZE (64 * 1024)
+///////////////////////////////////////////////////////////////////////////////
+
 ///////////////////////////////////////////////////////////////////////////////
 // Uncomment to avoid spdlog's usage of atomic log levels
 // Use only if your code never modifies a logger's log levels concurrently by
@@ -122,3 +129,10 @@
 //
 // #define SPDLOG_FUNCTION __PRETTY_FUNCTION__
 ///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// Uncomment to render the timestamps without SSE2 instructions (even if the
+// target supports them).
+//
+// #define SPDLOG_NO_SIMD
+///////////////////////////////////////////////////////////////////////////////
@@ -7,7 +7,11 @@
 
 #include <spdlog/async.h>
 #include <spdlog/async_logger-inl.h>
+#include <spdlog/details/crash_handler-inl.h>
 #include <spdlog/details/periodic_worker-inl.h>
 #include <spdlog/details/thread_pool-inl.h>
 
-template class SPDLOG_API spdlog::details::mpmc_blocking_queue<spdlog::details::async_msg>;
\ No newline at end of file
+template class SPDLOG_API spdlog::details::mpmc_blocking_queue<spdlog::details::async_msg>;
+template class SPDLOG_API spdlog::details::mpmc_lockfree_queue<spdlog::details::async_msg>;
+template class SPDLOG_API spdlog::details::thread_local_queue<spdlog::details::async_msg>;
+template class SPDLOG_API spdlog::details::mpmc_priority_queue<spdlog::details::async_msg>;
\ No newline at end of file
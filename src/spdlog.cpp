@@ -8,8 +8,12 @@
 #include <spdlog/spdlog-inl.h>
 #include <spdlog/common-inl.h>
 #include <spdlog/details/backtracer-inl.h>
+#include <spdlog/details/callsite-inl.h>
+#include <spdlog/details/sink_list-inl.h>
+#include <spdlog/details/scratch_buffer-inl.h>
 #include <spdlog/details/registry-inl.h>
 #include <spdlog/details/os-inl.h>
+#include <spdlog/details/civil_time-inl.h>
 #include <spdlog/pattern_formatter-inl.h>
 #include <spdlog/details/log_msg-inl.h>
 #include <spdlog/details/log_msg_buffer-inl.h>